@@ -0,0 +1,102 @@
+#include "conversion_arrow.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Buffers of an array produced by convertArrowColumn(), owned through
+// ArrowArray::private_data until the consumer releases the array
+struct OwnedColumn {
+    std::vector<std::uint8_t> validity;
+    std::vector<double> values;
+    const void* buffers[2];
+};
+
+static void releaseColumn(ArrowArray* array) {
+    delete static_cast<OwnedColumn*>(array->private_data);
+    array->release = nullptr;
+}
+
+static void releaseSchema(ArrowSchema* schema) {
+    delete static_cast<std::string*>(schema->private_data);
+    schema->release = nullptr;
+}
+
+static bool bitSet(const std::uint8_t* bitmap, std::int64_t index) {
+    return (bitmap[index >> 3] >> (index & 7)) & 1;
+}
+
+std::size_t convertArrowColumn(const UnitConverter& converter, ConversionId id, const ArrowSchema* schema,
+                               const ArrowArray* input, ArrowArray* output, ClampPolicy policy) {
+    if (!schema || !schema->format || std::strcmp(schema->format, "g") != 0) {
+        throw std::invalid_argument("Arrow column must be of type float64.");
+    }
+    if (!input || !input->release || input->n_buffers != 2 || !input->buffers || input->length < 0) {
+        throw std::invalid_argument("Arrow array is not a valid float64 array.");
+    }
+    const std::int64_t length = input->length;
+    const auto* inputValidity = static_cast<const std::uint8_t*>(input->buffers[0]);
+    const double* inputValues = static_cast<const double*>(input->buffers[1]);
+    if (length > 0 && !inputValues) {
+        throw std::invalid_argument("Arrow array is not a valid float64 array.");
+    }
+    if (input->null_count == 0) inputValidity = nullptr;
+    if (inputValues) inputValues += input->offset;
+
+    auto* column = new OwnedColumn;
+    column->values.resize(static_cast<std::size_t>(length));
+    column->validity.assign(static_cast<std::size_t>((length + 7) / 8), 0);
+
+    // Convert in chunks so the per-value validity flags stay in cache
+    std::size_t outOfRange = 0;
+    std::int64_t nullCount = 0;
+    std::uint8_t valid[1024];
+    try {
+        for (std::int64_t start = 0; start < length; start += 1024) {
+            const std::size_t count = static_cast<std::size_t>(std::min<std::int64_t>(1024, length - start));
+            converter.convertBatchChecked(id, inputValues + start, column->values.data() + start, valid, count, policy);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::int64_t index = start + static_cast<std::int64_t>(i);
+                const bool present = !inputValidity || bitSet(inputValidity, input->offset + index);
+                const bool ok = present && valid[i];
+                column->validity[index >> 3] |= static_cast<std::uint8_t>(ok << (index & 7));
+                nullCount += !ok;
+                outOfRange += present && std::fabs(inputValues[index]) > UnitConverter::clampLimit;
+            }
+        }
+    } catch (...) {
+        delete column;
+        throw;
+    }
+
+    column->buffers[0] = column->validity.data();
+    column->buffers[1] = column->values.data();
+
+    output->length = length;
+    output->null_count = nullCount;
+    output->offset = 0;
+    output->n_buffers = 2;
+    output->n_children = 0;
+    output->buffers = column->buffers;
+    output->children = nullptr;
+    output->dictionary = nullptr;
+    output->release = releaseColumn;
+    output->private_data = column;
+    return outOfRange;
+}
+
+void exportFloat64Schema(ArrowSchema* schema, const char* name) {
+    auto* ownedName = new std::string(name ? name : "");
+    schema->format = "g";
+    schema->name = ownedName->c_str();
+    schema->metadata = nullptr;
+    schema->flags = ARROW_FLAG_NULLABLE;
+    schema->n_children = 0;
+    schema->children = nullptr;
+    schema->dictionary = nullptr;
+    schema->release = releaseSchema;
+    schema->private_data = ownedName;
+}
@@ -0,0 +1,57 @@
+#ifndef CONVERSION_ARROW_H
+#define CONVERSION_ARROW_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <cstdint>
+
+// Structures of the Arrow C data interface, as given by the Arrow
+// specification. They are ABI-stable, so columns can be exchanged with any
+// Arrow implementation (C++, pyarrow, arrow-rs, ...) without linking Arrow.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+// Converts a float64 Arrow array (format "g") into a newly allocated float64
+// array in `output`, which the caller must eventually release. Nulls stay
+// null, and readings the conversion rejects become null instead of throwing.
+// Returns how many non-null inputs were beyond UnitConverter::clampLimit.
+// Throws std::invalid_argument if `schema` or `input` is not a float64 array.
+std::size_t convertArrowColumn(const UnitConverter& converter, ConversionId id, const ArrowSchema* schema,
+                               const ArrowArray* input, ArrowArray* output,
+                               ClampPolicy policy = ClampPolicy::Saturate);
+
+// Fills `schema` with a nullable float64 schema for a converted column
+void exportFloat64Schema(ArrowSchema* schema, const char* name = "");
+
+#endif // CONVERSION_ARROW_H
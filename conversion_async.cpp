@@ -0,0 +1,99 @@
+#include "conversion_async.h"
+#include <utility>
+
+ConversionExecutor::ConversionExecutor(unsigned threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { work(); });
+    }
+}
+
+ConversionExecutor::~ConversionExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ConversionExecutor::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wakeup.notify_one();
+}
+
+// Runs queued tasks until the executor is destroyed and the queue is drained
+void ConversionExecutor::work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+ConversionExecutor& ConversionExecutor::shared() {
+    static ConversionExecutor executor;
+    return executor;
+}
+
+ConversionAwaitable::ConversionAwaitable(const UnitConverter& converter, ConversionId id, const double* input,
+                                         double* output, std::size_t count, ClampPolicy policy,
+                                         ConversionExecutor& executor, ConversionResumer resumer)
+    : converter(converter), id(id), input(input), output(output), count(count), policy(policy),
+      executor(executor), resumer(std::move(resumer)) {}
+
+void ConversionAwaitable::run() {
+    try {
+        clamped = converter.convertBatch(id, input, output, count, policy);
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+bool ConversionAwaitable::await_ready() {
+    if (count >= inlineThreshold) return false;
+    run();
+    return true;
+}
+
+void ConversionAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    executor.post([this, handle] {
+        run();
+        // Once the coroutine may resume, the awaitable may be gone: take the
+        // resumer out of it first and touch no member afterwards
+        ConversionResumer resume = std::move(resumer);
+        if (resume) {
+            resume(handle);
+        } else {
+            handle.resume();
+        }
+    });
+}
+
+std::size_t ConversionAwaitable::await_resume() {
+    if (error) std::rethrow_exception(error);
+    return clamped;
+}
+
+ConversionAwaitable convertAsync(const UnitConverter& converter, ConversionId id, const double* input, double* output,
+                                 std::size_t count, ClampPolicy policy, ConversionExecutor& executor,
+                                 ConversionResumer resumer) {
+    return ConversionAwaitable(converter, id, input, output, count, policy, executor, std::move(resumer));
+}
+
+ConversionAwaitable convertAsync(const UnitConverter& converter, const std::string& conversionType, const double* input,
+                                 double* output, std::size_t count, ClampPolicy policy, ConversionExecutor& executor,
+                                 ConversionResumer resumer) {
+    // Unknown types throw here, before anything is suspended
+    return convertAsync(converter, converter.conversionId(conversionType), input, output, count, policy, executor,
+                        std::move(resumer));
+}
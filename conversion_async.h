@@ -0,0 +1,86 @@
+#ifndef CONVERSION_ASYNC_H
+#define CONVERSION_ASYNC_H
+
+#include "unit_converter.h"
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A small pool of background threads that conversion batches are offloaded to
+class ConversionExecutor {
+private:
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    void work();
+
+public:
+    explicit ConversionExecutor(unsigned threads = 1);
+    ~ConversionExecutor();
+
+    ConversionExecutor(const ConversionExecutor&) = delete;
+    ConversionExecutor& operator=(const ConversionExecutor&) = delete;
+
+    void post(std::function<void()> task);
+
+    // Process-wide executor used when none is given
+    static ConversionExecutor& shared();
+};
+
+// Decides where a suspended coroutine resumes once its batch is converted,
+// e.g. by posting the handle back onto the caller's event loop. Without one
+// the coroutine resumes on the executor thread.
+using ConversionResumer = std::function<void(std::coroutine_handle<>)>;
+
+// Awaitable returned by convertAsync(). Batches smaller than inlineThreshold
+// are converted on the spot without suspending; larger ones are converted on
+// the executor so that the awaiting thread stays free. co_await yields what
+// convertBatch() returns and rethrows what it throws.
+class ConversionAwaitable {
+private:
+    const UnitConverter& converter;
+    ConversionId id;
+    const double* input;
+    double* output;
+    std::size_t count;
+    ClampPolicy policy;
+    ConversionExecutor& executor;
+    ConversionResumer resumer;
+    std::size_t clamped = 0;
+    std::exception_ptr error;
+
+    void run();
+
+public:
+    static constexpr std::size_t inlineThreshold = 4096;
+
+    ConversionAwaitable(const UnitConverter& converter, ConversionId id, const double* input, double* output,
+                        std::size_t count, ClampPolicy policy, ConversionExecutor& executor, ConversionResumer resumer);
+
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> handle);
+    std::size_t await_resume();
+};
+
+// Converts `count` values like UnitConverter::convertBatch(), for use with
+// co_await. The buffers must stay alive until the co_await completes.
+ConversionAwaitable convertAsync(const UnitConverter& converter, ConversionId id, const double* input, double* output,
+                                 std::size_t count, ClampPolicy policy = ClampPolicy::Saturate,
+                                 ConversionExecutor& executor = ConversionExecutor::shared(),
+                                 ConversionResumer resumer = nullptr);
+ConversionAwaitable convertAsync(const UnitConverter& converter, const std::string& conversionType, const double* input,
+                                 double* output, std::size_t count, ClampPolicy policy = ClampPolicy::Saturate,
+                                 ConversionExecutor& executor = ConversionExecutor::shared(),
+                                 ConversionResumer resumer = nullptr);
+
+#endif // CONVERSION_ASYNC_H
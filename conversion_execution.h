@@ -0,0 +1,70 @@
+#ifndef CONVERSION_EXECUTION_H
+#define CONVERSION_EXECUTION_H
+
+#include "unit_converter.h"
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Conversions for the standard parallel algorithms:
+//
+//     convert(std::execution::par_unseq, in.begin(), in.end(), out.begin(),
+//             checkedConversion(converter, "KilometersToMiles"));
+//
+// Values are validated and clamped like UnitConverter::convert(), but an
+// invalid value turns into NaN (and a 0 valid flag) instead of throwing, so
+// the element function is safe under every execution policy. With libstdc++,
+// the parallel policies run on TBB when its headers are installed, and the
+// program must then link with -ltbb.
+
+// Converts one value with UnitConverter::convertChecked(). Cheap to copy,
+// and the converter must outlive it.
+struct CheckedConversion {
+    const UnitConverter* converter;
+    ConversionId id;
+    ClampPolicy policy;
+
+    double operator()(double value) const noexcept { return converter->convertChecked(id, value, policy); }
+    bool accepts(double value) const noexcept { return converter->accepts(id, value, policy); }
+};
+
+// Unknown conversions are reported here, once, by throwing like
+// UnitConverter::conversionName() and conversionId()
+inline CheckedConversion checkedConversion(const UnitConverter& converter, ConversionId id,
+                                           ClampPolicy policy = ClampPolicy::Saturate) {
+    converter.conversionName(id);
+    return {&converter, id, policy};
+}
+
+inline CheckedConversion checkedConversion(const UnitConverter& converter, const std::string& conversionType,
+                                           ClampPolicy policy = ClampPolicy::Saturate) {
+    return {&converter, converter.conversionId(conversionType), policy};
+}
+
+// Converts [first, last) into `out` (which may be `first`) under `policy`,
+// writing NaN for invalid values, and returns the end of the output like
+// std::transform()
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2>
+    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+ForwardIt2 convert(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last, ForwardIt2 out,
+                   const CheckedConversion& conversion) {
+    return std::transform(std::forward<ExecutionPolicy>(policy), first, last, out, conversion);
+}
+
+// The same, also writing whether each value was valid to `valid` (e.g. bool
+// or std::uint8_t elements, telling invalid values from NaN inputs), and
+// returning the number of invalid values
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2, typename ForwardIt3>
+    requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+std::size_t convert(ExecutionPolicy&& policy, ForwardIt1 first, ForwardIt1 last, ForwardIt2 out, ForwardIt3 valid,
+                    const CheckedConversion& conversion) {
+    const ForwardIt3 validEnd =
+        std::transform(policy, first, last, valid, [conversion](double value) { return conversion.accepts(value); });
+    std::transform(policy, first, last, out, conversion);
+    return static_cast<std::size_t>(std::count(policy, valid, validEnd, false));
+}
+
+#endif // CONVERSION_EXECUTION_H
@@ -0,0 +1,249 @@
+#include "conversion_expression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+// Recursive-descent parser that emits bytecode while it parses, tracking the
+// unit of every subexpression and the deepest stack the code will need
+class ExpressionParser {
+private:
+    const UnitConverter& converter;
+    const std::string& source;
+    const std::vector<ExpressionVariable>& variables;
+    std::size_t position = 0;
+    std::size_t depth = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument("Expression error at position " + std::to_string(position) + ": " + message);
+    }
+
+    void skipSpaces() {
+        while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position]))) ++position;
+    }
+
+    bool accept(char expected) {
+        skipSpaces();
+        if (position < source.size() && source[position] == expected) {
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char expected) {
+        if (!accept(expected)) fail(std::string("expected '") + expected + "'");
+    }
+
+    std::string identifier() {
+        skipSpaces();
+        const std::size_t start = position;
+        while (position < source.size() &&
+               (std::isalnum(static_cast<unsigned char>(source[position])) || source[position] == '_')) {
+            ++position;
+        }
+        if (start == position || std::isdigit(static_cast<unsigned char>(source[start]))) {
+            position = start;
+            fail("expected a name");
+        }
+        return source.substr(start, position - start);
+    }
+
+    void emit(CompiledExpression::OpCode op, std::uint32_t operand = 0, double constant = 0.0) {
+        code.push_back({op, operand, constant});
+        if (op == CompiledExpression::OpCode::PushConstant || op == CompiledExpression::OpCode::LoadVariable) {
+            maxDepth = std::max(maxDepth, ++depth);
+        } else if (op != CompiledExpression::OpCode::Convert && op != CompiledExpression::OpCode::Negate) {
+            --depth;
+        }
+    }
+
+    // Resolves a unit name, symbol or alias to its canonical unit
+    const UnitInfo* resolveUnit(const std::string& name, std::size_t at) {
+        const UnitInfo* unit = findUnit(name);
+        if (!unit) {
+            position = at;
+            fail("unknown unit " + name);
+        }
+        return unit;
+    }
+
+    // Each parse step returns the unit of what it parsed, nullptr for plain
+    // numbers. Units are canonical, so aliases of one unit compare equal.
+    const UnitInfo* factor() {
+        skipSpaces();
+        if (position >= source.size()) fail("unexpected end of expression");
+
+        const char c = source[position];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* start = source.c_str() + position;
+            char* end;
+            const double value = std::strtod(start, &end);
+            if (end == start) fail("invalid number");
+            position += static_cast<std::size_t>(end - start);
+            emit(CompiledExpression::OpCode::PushConstant, 0, value);
+            return nullptr;
+        }
+        if (accept('-')) {
+            const UnitInfo* unit = factor();
+            emit(CompiledExpression::OpCode::Negate);
+            return unit;
+        }
+        if (accept('(')) {
+            const UnitInfo* unit = expression();
+            expect(')');
+            return unit;
+        }
+
+        const std::size_t start = position;
+        const std::string name = identifier();
+        if (name == "to" && accept('(')) {
+            skipSpaces();
+            const std::size_t targetStart = position;
+            const UnitInfo* target = resolveUnit(identifier(), targetStart);
+            expect(',');
+            const std::size_t argument = position;
+            const UnitInfo* unit = expression();
+            expect(')');
+            if (!unit) {
+                position = argument;
+                fail("the argument of to() has no unit");
+            }
+            if (unit != target) {
+                try {
+                    emit(CompiledExpression::OpCode::Convert,
+                         converter.conversionId(unitId(unit->name), unitId(target->name)));
+                } catch (const std::invalid_argument&) {
+                    position = start;
+                    fail(std::string("no conversion from ") + unit->name + " to " + target->name);
+                }
+            }
+            return target;
+        }
+
+        for (std::size_t i = 0; i < variables.size(); ++i) {
+            if (variables[i].name == name) {
+                const UnitInfo* unit = variables[i].unit.empty() ? nullptr : resolveUnit(variables[i].unit, start);
+                emit(CompiledExpression::OpCode::LoadVariable, static_cast<std::uint32_t>(i));
+                return unit;
+            }
+        }
+        position = start;
+        fail("unknown variable " + name);
+    }
+
+    // Units are not raised to powers: a unit may only be scaled by a plain
+    // number, or divided by the same unit into a plain ratio
+    const UnitInfo* term() {
+        const UnitInfo* unit = factor();
+        for (;;) {
+            const std::size_t start = position;
+            const bool multiply = accept('*');
+            if (!multiply && !accept('/')) return unit;
+            const UnitInfo* right = factor();
+            emit(multiply ? CompiledExpression::OpCode::Multiply : CompiledExpression::OpCode::Divide);
+            if (!right) continue;
+            if (!unit && multiply) {
+                unit = right;
+            } else if (!multiply && unit == right) {
+                unit = nullptr;
+            } else {
+                position = start;
+                fail(multiply ? std::string("cannot multiply ") + unit->name + " by " + right->name
+                              : std::string("cannot divide ") + (unit ? unit->name : "a plain number") + " by " +
+                                    right->name);
+            }
+        }
+    }
+
+public:
+    std::vector<CompiledExpression::Instruction> code;
+    std::size_t maxDepth = 0;
+
+    ExpressionParser(const UnitConverter& converter, const std::string& source,
+                     const std::vector<ExpressionVariable>& variables)
+        : converter(converter), source(source), variables(variables) {}
+
+    const UnitInfo* expression() {
+        const UnitInfo* unit = term();
+        for (;;) {
+            const std::size_t start = position;
+            const bool add = accept('+');
+            if (!add && !accept('-')) return unit;
+            const UnitInfo* right = term();
+            // Plain numbers take the unit of the other side
+            if (unit && right && unit != right) {
+                position = start;
+                fail(std::string("cannot combine ") + unit->name + " with " + right->name);
+            }
+            if (!unit) unit = right;
+            emit(add ? CompiledExpression::OpCode::Add : CompiledExpression::OpCode::Subtract);
+        }
+    }
+
+    void finish() {
+        skipSpaces();
+        if (position != source.size()) fail("unexpected input");
+    }
+};
+
+CompiledExpression::CompiledExpression(const UnitConverter& converter, const std::string& source,
+                                       const std::vector<ExpressionVariable>& variables)
+    : converter(converter) {
+    ExpressionParser parser(converter, source, variables);
+    const UnitInfo* result = parser.expression();
+    parser.finish();
+    if (result) unit = result->name;
+    code = std::move(parser.code);
+    stackDepth = parser.maxDepth;
+}
+
+void CompiledExpression::evaluate(const double* const* inputs, double* output, std::size_t count) const {
+    // One block-sized column per stack slot; each instruction runs over a
+    // whole block, so dispatch is paid once per block instead of per record
+    std::vector<double> storage(stackDepth * blockSize);
+    std::vector<double*> stack(stackDepth);
+    for (std::size_t i = 0; i < stackDepth; ++i) stack[i] = storage.data() + i * blockSize;
+
+    for (std::size_t start = 0; start < count; start += blockSize) {
+        const std::size_t n = std::min(blockSize, count - start);
+        std::size_t top = 0;
+
+        for (const Instruction& instruction : code) {
+            switch (instruction.op) {
+            case OpCode::PushConstant:
+                std::fill(stack[top], stack[top] + n, instruction.constant);
+                ++top;
+                break;
+            case OpCode::LoadVariable:
+                std::copy(inputs[instruction.operand] + start, inputs[instruction.operand] + start + n, stack[top]);
+                ++top;
+                break;
+            case OpCode::Convert:
+                converter.convertBatch(instruction.operand, stack[top - 1], stack[top - 1], n);
+                break;
+            case OpCode::Negate: {
+                double* a = stack[top - 1];
+                for (std::size_t i = 0; i < n; ++i) a[i] = -a[i];
+                break;
+            }
+            default: {
+                double* a = stack[top - 2];
+                const double* b = stack[top - 1];
+                if (instruction.op == OpCode::Add) {
+                    for (std::size_t i = 0; i < n; ++i) a[i] += b[i];
+                } else if (instruction.op == OpCode::Subtract) {
+                    for (std::size_t i = 0; i < n; ++i) a[i] -= b[i];
+                } else if (instruction.op == OpCode::Multiply) {
+                    for (std::size_t i = 0; i < n; ++i) a[i] *= b[i];
+                } else {
+                    for (std::size_t i = 0; i < n; ++i) a[i] /= b[i];
+                }
+                --top;
+                break;
+            }
+            }
+        }
+        std::copy(stack[0], stack[0] + n, output + start);
+    }
+}
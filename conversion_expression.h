@@ -0,0 +1,63 @@
+#ifndef CONVERSION_EXPRESSION_H
+#define CONVERSION_EXPRESSION_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An input column of an expression and the unit its values are in
+struct ExpressionVariable {
+    std::string name;
+    std::string unit; // e.g. "Kilometers" or "km"; empty for plain numbers
+};
+
+// An expression such as `to(Miles, distance_km) * 2 + to(Miles, offset_m)`,
+// compiled once into flat stack bytecode and then evaluated over whole
+// batches of records, one instruction at a time per block of records.
+//
+// Grammar:
+//   expression := term (('+' | '-') term)*
+//   term       := factor (('*' | '/') factor)*
+//   factor     := number | variable | '-' factor | '(' expression ')'
+//               | 'to' '(' Unit ',' expression ')'
+//
+// Units are checked while compiling, by canonical unit, so "mi" and "Miles"
+// match: to() needs an argument with a unit of the target's dimension, and
+// + and - need matching units (plain numbers take the unit of the other
+// side). Units have no powers, so * and / only scale a unit by a plain
+// number or divide a unit by itself.
+class CompiledExpression {
+public:
+    enum class OpCode : std::uint8_t { PushConstant, LoadVariable, Convert, Add, Subtract, Multiply, Divide, Negate };
+
+    struct Instruction {
+        OpCode op;
+        std::uint32_t operand; // variable index or conversion id
+        double constant;
+    };
+
+    static constexpr std::size_t blockSize = 512;
+
+    // Throws std::invalid_argument describing the first error in `source`
+    CompiledExpression(const UnitConverter& converter, const std::string& source,
+                       const std::vector<ExpressionVariable>& variables);
+
+    // Evaluates the expression for `count` records. inputs[v] holds the values
+    // of variables[v]. Conversions validate like UnitConverter::convertBatch()
+    // and throw the same way.
+    void evaluate(const double* const* inputs, double* output, std::size_t count) const;
+
+    const std::vector<Instruction>& instructions() const { return code; }
+    // Canonical name of the result's unit, empty if it is a plain number
+    const std::string& resultUnit() const { return unit; }
+
+private:
+    const UnitConverter& converter;
+    std::vector<Instruction> code;
+    std::size_t stackDepth = 0;
+    std::string unit;
+};
+
+#endif // CONVERSION_EXPRESSION_H
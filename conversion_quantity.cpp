@@ -0,0 +1,183 @@
+#include "conversion_quantity.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// Maps each byte to its letter in the trie's alphabet, folding case; 0 for
+// bytes that never occur in a unit. The degree sign is matched by its two
+// UTF-8 bytes.
+static constexpr std::array<std::uint8_t, 256> trieAlphabet = [] {
+    std::array<std::uint8_t, 256> alphabet{};
+    for (int c = 'a'; c <= 'z'; ++c) {
+        alphabet[c] = static_cast<std::uint8_t>(c - 'a' + 1);
+        alphabet[c - 'a' + 'A'] = alphabet[c];
+    }
+    alphabet['/'] = 27;
+    alphabet['.'] = 28;
+    alphabet[' '] = 29;
+    alphabet['\''] = 30;
+    alphabet[0xC2] = 31;
+    alphabet[0xB0] = 32;
+    return alphabet;
+}();
+
+// Trie over the case-folded spellings of every unit (names, symbols and the
+// converter's aliases), built once. Nodes are stored flat and refer to their
+// children by index, so a lookup is one table load per byte.
+class UnitTrie {
+private:
+    struct Node {
+        std::uint16_t next[33] = {};
+        std::int16_t unit = -1;
+    };
+    std::vector<Node> nodes;
+
+    void insert(std::string_view key, std::size_t unit) {
+        std::size_t node = 0;
+        for (char c : key) {
+            const std::uint8_t letter = trieAlphabet[static_cast<unsigned char>(c)];
+            if (nodes[node].next[letter] == 0) {
+                nodes[node].next[letter] = static_cast<std::uint16_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            node = nodes[node].next[letter];
+        }
+        nodes[node].unit = static_cast<std::int16_t>(unit);
+    }
+
+public:
+    UnitTrie() : nodes(1) {
+        for (std::size_t id = 0; id < unitCount(); ++id) {
+            const UnitInfo& unit = unitInfo(static_cast<UnitId>(id));
+            insert(unit.name, id);
+            insert(unit.symbol, id);
+        }
+        for (const UnitAlias& alias : listUnitAliases()) insert(alias.alias, unitId(alias.unit));
+    }
+
+    // Id of the unit spelled by `text`, which may end in spaces; -1 if none
+    int match(std::string_view text) const {
+        std::size_t node = 0;
+        int unit = -1;
+        std::size_t matched = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const std::uint8_t letter = trieAlphabet[static_cast<unsigned char>(text[i])];
+            node = nodes[node].next[letter];
+            if (letter == 0 || node == 0) break;
+            if (nodes[node].unit >= 0) {
+                unit = nodes[node].unit;
+                matched = i + 1;
+            }
+        }
+        for (std::size_t i = matched; i < text.size(); ++i) {
+            if (text[i] != ' ' && text[i] != '\t') return -1;
+        }
+        return unit;
+    }
+};
+
+static const UnitTrie& unitTrie() {
+    static const UnitTrie trie;
+    return trie;
+}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Splits `text` into a number and the id of its unit; returns -1 if it is not
+// a quantity
+static int scanQuantity(std::string_view text, double& value) {
+    const char* position = text.data();
+    const char* end = position + text.size();
+    while (position != end && isBlank(*position)) ++position;
+
+    const bool negative = position != end && *position == '-';
+    if (position != end && (*position == '-' || *position == '+')) ++position;
+    // Only plain decimals: from_chars would also take "inf" and "nan"
+    if (position == end || !((*position >= '0' && *position <= '9') || *position == '.')) return -1;
+
+    const auto [next, error] = std::from_chars(position, end, value);
+    if (error != std::errc()) return -1;
+    if (negative) value = -value;
+
+    position = next;
+    while (position != end && isBlank(*position)) ++position;
+    return unitTrie().match(std::string_view(position, static_cast<std::size_t>(end - position)));
+}
+
+bool parseQuantity(std::string_view text, Quantity& quantity) {
+    double value;
+    const int unit = scanQuantity(text, value);
+    if (unit < 0) return false;
+    quantity = {value, &unitInfo(static_cast<UnitId>(unit))};
+    return true;
+}
+
+Quantity parseQuantity(std::string_view text) {
+    Quantity quantity;
+    if (!parseQuantity(text, quantity)) {
+        throw std::invalid_argument("Invalid quantity: " + std::string(text));
+    }
+    return quantity;
+}
+
+QuantityConverter::QuantityConverter(const UnitConverter& converter, const std::string& targetUnit)
+    : converter(converter), target(findUnit(targetUnit)) {
+    if (!target) throw std::invalid_argument("Unknown unit: " + targetUnit);
+
+    const UnitId to = unitId(target->name);
+    for (std::size_t id = 0; id < unitCount(); ++id) {
+        const UnitId from = static_cast<UnitId>(id);
+        const bool convertible = unitInfo(from).dimension == target->dimension;
+        routes.push_back({convertible, convertible ? converter.conversionId(from, to) : 0});
+    }
+}
+
+double QuantityConverter::convert(std::string_view text, ClampPolicy policy) const {
+    double value;
+    const int unit = scanQuantity(text, value);
+    if (unit < 0) throw std::invalid_argument("Invalid quantity: " + std::string(text));
+
+    const Route& route = routes[unit];
+    if (!route.convertible) {
+        throw std::invalid_argument(std::string("Cannot convert ") + unitInfo(static_cast<UnitId>(unit)).symbol + " to " +
+                                    target->symbol);
+    }
+    return converter.convert(route.id, value, policy);
+}
+
+std::size_t QuantityConverter::convertBatch(const std::string_view* texts, double* output, std::uint8_t* valid,
+                                            std::size_t count, ClampPolicy policy) const {
+    // Parse a chunk at a time, then convert each run of texts in the same
+    // unit with one batch call
+    constexpr std::size_t chunkSize = 1024;
+    double values[chunkSize];
+    int units[chunkSize];
+    std::size_t outOfRange = 0;
+
+    for (std::size_t start = 0; start < count; start += chunkSize) {
+        const std::size_t n = std::min(chunkSize, count - start);
+        for (std::size_t i = 0; i < n; ++i) {
+            units[i] = scanQuantity(texts[start + i], values[i]);
+            if (units[i] >= 0 && !routes[units[i]].convertible) units[i] = -1;
+        }
+
+        for (std::size_t i = 0; i < n;) {
+            std::size_t end = i + 1;
+            while (end < n && units[end] == units[i]) ++end;
+            if (units[i] < 0) {
+                std::fill(output + start + i, output + start + end, std::numeric_limits<double>::quiet_NaN());
+                std::fill(valid + start + i, valid + start + end, std::uint8_t(0));
+            } else {
+                outOfRange += converter.convertBatchChecked(routes[units[i]].id, values + i, output + start + i,
+                                                            valid + start + i, end - i, policy);
+            }
+            i = end;
+        }
+    }
+    return outOfRange;
+}
@@ -0,0 +1,56 @@
+#ifndef CONVERSION_QUANTITY_H
+#define CONVERSION_QUANTITY_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A number and the unit it was written with
+struct Quantity {
+    double value;
+    const UnitInfo* unit;
+};
+
+// Parses free text such as "12.5 km", "98.6°F", "-40 F" or "3 lbs": a decimal
+// number, optional spaces, then a unit symbol, name or common alias in any
+// case. Leading and trailing spaces are ignored. Returns false if `text` is
+// not of that form; parseQuantity(text) throws std::invalid_argument instead.
+bool parseQuantity(std::string_view text, Quantity& quantity);
+Quantity parseQuantity(std::string_view text);
+
+// Converts free-text quantities of one dimension into a fixed target unit,
+// with the conversion for every source unit looked up once up front
+class QuantityConverter {
+public:
+    // Throws std::invalid_argument if `targetUnit` is not a known unit name
+    QuantityConverter(const UnitConverter& converter, const std::string& targetUnit);
+
+    // Throws std::invalid_argument for unparsable text, units of another
+    // dimension and anything UnitConverter::convert() would reject. Values
+    // already in the target unit are validated and clamped the same way.
+    double convert(std::string_view text, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    // Like UnitConverter::convertBatchChecked(): unparsable or invalid texts
+    // get valid[i] = 0 and a NaN result instead of throwing. Returns how many
+    // parsed values were beyond UnitConverter::clampLimit.
+    std::size_t convertBatch(const std::string_view* texts, double* output, std::uint8_t* valid,
+                             std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    const UnitInfo& targetUnit() const { return *target; }
+
+private:
+    // How values in each unit known to the parser reach the target unit
+    struct Route {
+        bool convertible;   // same dimension as the target
+        ConversionId id;
+    };
+
+    const UnitConverter& converter;
+    const UnitInfo* target;
+    std::vector<Route> routes; // indexed by UnitId
+};
+
+#endif // CONVERSION_QUANTITY_H
@@ -0,0 +1,216 @@
+#include "conversion_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static std::system_error systemError(const char* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+static std::size_t ringSize(std::uint32_t capacity) {
+    return sizeof(RingControl) + std::size_t(capacity) * (sizeof(double) + sizeof(ConversionId) + sizeof(RingStatus));
+}
+
+// Sleeps on `word` while it still holds `value`. The timeout bounds how long a
+// missed wake-up (e.g. a peer that died) can stall the caller.
+static void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t value) {
+    timespec timeout{0, 100 * 1000 * 1000};
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<std::uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+// Waits for `word` to move past `value`: spins first, then sleeps with
+// `sleeping` raised so that the other side knows to wake us. Returns on
+// change, timeout or spurious wake-up; callers re-check their condition.
+static void waitForChange(std::atomic<std::uint32_t>& word, std::uint32_t value, std::atomic<std::uint32_t>& sleeping) {
+    for (int i = 0; i < ConversionRing::spinIterations; ++i) {
+        if (word.load(std::memory_order_acquire) != value) return;
+    }
+    sleeping.store(1);
+    if (word.load() == value) futexWait(word, value);
+    sleeping.store(0, std::memory_order_relaxed);
+}
+
+ConversionRing::ConversionRing(const std::string& name, bool create, std::uint32_t capacity)
+    : name(name), owner(create) {
+    if (create) {
+        shm_unlink(name.c_str());
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) throw systemError("shm_open");
+        if (ftruncate(fd, static_cast<off_t>(ringSize(capacity))) < 0) {
+            const std::system_error error = systemError("ftruncate");
+            close(fd);
+            shm_unlink(name.c_str());
+            throw error;
+        }
+        map(fd, ringSize(capacity));
+        control = new (mapping) RingControl();
+        control->capacity = capacity;
+    } else {
+        const int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) throw systemError("shm_open");
+        struct stat info;
+        if (fstat(fd, &info) < 0 || std::size_t(info.st_size) < sizeof(RingControl)) {
+            close(fd);
+            throw std::runtime_error("Not a conversion ring: " + name);
+        }
+        map(fd, std::size_t(info.st_size));
+        control = static_cast<RingControl*>(mapping);
+        capacity = control->capacity;
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 || ringSize(capacity) != mappingSize) {
+            munmap(mapping, mappingSize);
+            throw std::runtime_error("Not a conversion ring: " + name);
+        }
+    }
+
+    char* base = static_cast<char*>(mapping) + sizeof(RingControl);
+    values = reinterpret_cast<double*>(base);
+    ids = reinterpret_cast<ConversionId*>(base + std::size_t(capacity) * sizeof(double));
+    status = reinterpret_cast<RingStatus*>(base + std::size_t(capacity) * (sizeof(double) + sizeof(ConversionId)));
+    collected = control->completed.load();
+}
+
+// Maps the whole object and closes the descriptor, which the mapping outlives
+void ConversionRing::map(int fd, std::size_t size) {
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    close(fd);
+    if (address == MAP_FAILED) {
+        if (owner) shm_unlink(name.c_str());
+        errno = error;
+        throw systemError("mmap");
+    }
+    mapping = address;
+    mappingSize = size;
+}
+
+ConversionRing ConversionRing::create(const std::string& name, std::uint32_t capacity) {
+    if (capacity == 0 || capacity > (1u << 30)) {
+        throw std::invalid_argument("Ring capacity must be between 1 and 2^30.");
+    }
+    std::uint32_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    return ConversionRing(name, true, rounded);
+}
+
+ConversionRing ConversionRing::attach(const std::string& name) {
+    return ConversionRing(name, false, 0);
+}
+
+ConversionRing::ConversionRing(ConversionRing&& other) noexcept
+    : name(std::move(other.name)), owner(other.owner), mapping(other.mapping), mappingSize(other.mappingSize),
+      control(other.control), values(other.values), ids(other.ids), status(other.status), collected(other.collected) {
+    other.owner = false;
+    other.mapping = nullptr;
+}
+
+ConversionRing::~ConversionRing() {
+    if (mapping) munmap(mapping, mappingSize);
+    if (owner) shm_unlink(name.c_str());
+}
+
+std::uint32_t ConversionRing::submit(ConversionId id, const double* input, std::uint32_t count) {
+    const std::uint32_t mask = control->capacity - 1;
+    const std::uint32_t head = control->submitted.load(std::memory_order_relaxed);
+    const std::uint32_t room = control->capacity - (head - collected);
+    const std::uint32_t accepted = std::min(room, count);
+
+    for (std::uint32_t i = 0; i < accepted; ++i) {
+        const std::uint32_t slot = (head + i) & mask;
+        values[slot] = input[i];
+        ids[slot] = id;
+    }
+    if (accepted == 0) return 0;
+
+    control->submitted.store(head + accepted);
+    if (control->converterSleeping.load()) futexWake(control->submitted);
+    return accepted;
+}
+
+std::uint32_t ConversionRing::collect(double* output, RingStatus* statuses, std::uint32_t maxCount) {
+    const std::uint32_t mask = control->capacity - 1;
+    const std::uint32_t done = control->completed.load(std::memory_order_acquire);
+    const std::uint32_t count = std::min(done - collected, maxCount);
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint32_t slot = (collected + i) & mask;
+        output[i] = values[slot];
+        if (statuses) statuses[i] = status[slot];
+    }
+    collected += count;
+    return count;
+}
+
+void ConversionRing::waitForResults() {
+    while (control->completed.load(std::memory_order_acquire) == collected) {
+        waitForChange(control->completed, collected, control->producerSleeping);
+    }
+}
+
+void ConversionRing::serve(const UnitConverter& converter, ClampPolicy policy) {
+    const std::uint32_t capacity = control->capacity;
+    const std::uint32_t mask = capacity - 1;
+    std::uint32_t done = control->completed.load(std::memory_order_relaxed);
+
+    while (!control->shutdown.load(std::memory_order_acquire)) {
+        const std::uint32_t ready = control->submitted.load(std::memory_order_acquire);
+        if (ready == done) {
+            waitForChange(control->submitted, done, control->converterSleeping);
+            continue;
+        }
+
+        // Convert runs of slots that share a conversion id in place, one batch
+        // call per run, without crossing the end of the arrays
+        std::uint32_t position = done;
+        while (position != ready) {
+            const std::uint32_t start = position & mask;
+            const ConversionId id = ids[start];
+            std::uint32_t length = 1;
+            while (position + length != ready && start + length < capacity && ids[start + length] == id) ++length;
+
+            double* run = values + start;
+            try {
+                converter.convertBatch(id, run, run, length, policy);
+                std::fill(status + start, status + start + length, RingStatus::Ok);
+            } catch (const std::exception&) {
+                // Some value in the run was rejected: redo it one value at a
+                // time. Inputs are at most clamped by the failed batch, which
+                // does not change whether they are valid.
+                for (std::uint32_t i = 0; i < length; ++i) {
+                    try {
+                        run[i] = converter.convert(id, run[i], policy);
+                        status[start + i] = RingStatus::Ok;
+                    } catch (const std::exception&) {
+                        run[i] = std::numeric_limits<double>::quiet_NaN();
+                        status[start + i] = RingStatus::Invalid;
+                    }
+                }
+            }
+            position += length;
+        }
+
+        done = ready;
+        control->completed.store(done);
+        if (control->producerSleeping.load()) futexWake(control->completed);
+    }
+}
+
+void ConversionRing::shutdown() {
+    control->shutdown.store(1);
+    futexWake(control->submitted);
+}
@@ -0,0 +1,79 @@
+#ifndef CONVERSION_RING_H
+#define CONVERSION_RING_H
+
+#include "unit_converter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Control block at the start of a shared-memory conversion ring. The producer
+// owns `submitted` and the converter owns `completed`; both only ever grow and
+// wrap around at 2^32. Slot i lives at index i & (capacity - 1) of the value,
+// id and status arrays that follow the control block.
+struct RingControl {
+    alignas(64) std::atomic<std::uint32_t> submitted;
+    std::atomic<std::uint32_t> converterSleeping;
+    alignas(64) std::atomic<std::uint32_t> completed;
+    std::atomic<std::uint32_t> producerSleeping;
+    alignas(64) std::uint32_t capacity; // a power of two
+    std::atomic<std::uint32_t> shutdown;
+};
+
+// Per-slot result status written by the converter
+enum class RingStatus : std::uint8_t { Ok = 0, Invalid = 1 };
+
+// A single-producer/single-consumer ring in POSIX shared memory. The producer
+// writes raw values and conversion ids into the ring and the converter
+// process converts them in place, so values are never copied through a
+// socket. Both sides spin briefly before sleeping on a futex, and only issue
+// a wake-up when the other side is actually asleep, so a busy ring does no
+// system calls at all.
+class ConversionRing {
+private:
+    std::string name;
+    bool owner = false;
+    void* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    RingControl* control = nullptr;
+    double* values = nullptr;
+    ConversionId* ids = nullptr;
+    RingStatus* status = nullptr;
+    std::uint32_t collected = 0; // producer-side: results handed back so far
+
+    ConversionRing(const std::string& name, bool create, std::uint32_t capacity);
+    void map(int fd, std::size_t size);
+
+public:
+    static constexpr int spinIterations = 4096;
+
+    // Creates the shared-memory object `name` (e.g. "/unit_converter") with
+    // room for `capacity` values, rounded up to a power of two. The creating
+    // side unlinks the object again when it is destroyed.
+    static ConversionRing create(const std::string& name, std::uint32_t capacity);
+    // Maps a ring that another process created
+    static ConversionRing attach(const std::string& name);
+
+    ConversionRing(ConversionRing&& other) noexcept;
+    ConversionRing& operator=(ConversionRing&&) = delete;
+    ConversionRing(const ConversionRing&) = delete;
+    ConversionRing& operator=(const ConversionRing&) = delete;
+    ~ConversionRing();
+
+    std::uint32_t capacity() const { return control->capacity; }
+
+    // Producer side. submit() copies as many of `count` values as there is
+    // room for into the ring and returns how many it took. collect() hands
+    // back up to `maxCount` converted values in submission order; rejected
+    // values come back as NaN with RingStatus::Invalid.
+    std::uint32_t submit(ConversionId id, const double* input, std::uint32_t count);
+    std::uint32_t collect(double* output, RingStatus* statuses, std::uint32_t maxCount);
+    // Blocks until collect() has something to return
+    void waitForResults();
+
+    // Converter side: converts submitted values in place until shutdown()
+    void serve(const UnitConverter& converter, ClampPolicy policy = ClampPolicy::Saturate);
+    void shutdown();
+};
+
+#endif // CONVERSION_RING_H
@@ -0,0 +1,55 @@
+#include "conversion_scaled.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+bool convertScaledColumn(const UnitConverter& converter, ConversionId id, ScaledColumn& column, ClampPolicy policy) {
+    const ScaledEncoding from = column.encoding;
+    const UnitConverter::AffineMap map = converter.affineMap(id);
+    const ScaledEncoding to{from.scale * map.scale, from.offset * map.scale + map.offset};
+
+    // Conversions are monotonic, so the extremes decide whether any value is
+    // rejected or needs clamping
+    bool clamped = false;
+    if (column.count != 0) {
+        bool lowClamped, highClamped;
+        converter.convert(id, column.rawMin * from.scale + from.offset, policy, &lowClamped);
+        converter.convert(id, column.rawMax * from.scale + from.offset, policy, &highClamped);
+        clamped = (lowClamped || highClamped) && policy == ClampPolicy::Saturate;
+    }
+
+    if (clamped) {
+        reencodeScaledColumn(converter, id, column.raw, column.raw, column.count, from, to, policy);
+        const auto bounds = std::minmax_element(column.raw, column.raw + column.count);
+        column.rawMin = *bounds.first;
+        column.rawMax = *bounds.second;
+    }
+    column.encoding = to;
+    return !clamped;
+}
+
+std::size_t reencodeScaledColumn(const UnitConverter& converter, ConversionId id, const std::int32_t* raw,
+                                 std::int32_t* output, std::size_t count, const ScaledEncoding& from,
+                                 const ScaledEncoding& to, ClampPolicy policy) {
+    if (to.scale == 0.0) {
+        throw std::invalid_argument("Scaled encoding must have a non-zero scale.");
+    }
+    const double lowest = std::numeric_limits<std::int32_t>::min();
+    const double highest = std::numeric_limits<std::int32_t>::max();
+
+    // Decode a chunk, convert it with the batch kernel, then encode it back
+    constexpr std::size_t chunkSize = 1024;
+    double values[chunkSize];
+    std::size_t outOfRange = 0;
+    for (std::size_t start = 0; start < count; start += chunkSize) {
+        const std::size_t n = std::min(chunkSize, count - start);
+        for (std::size_t i = 0; i < n; ++i) values[i] = raw[start + i] * from.scale + from.offset;
+        outOfRange += converter.convertBatch(id, values, values, n, policy);
+        for (std::size_t i = 0; i < n; ++i) {
+            const double encoded = std::nearbyint((values[i] - to.offset) / to.scale);
+            output[start + i] = static_cast<std::int32_t>(std::min(std::max(encoded, lowest), highest));
+        }
+    }
+    return outOfRange;
+}
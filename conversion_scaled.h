@@ -0,0 +1,47 @@
+#ifndef CONVERSION_SCALED_H
+#define CONVERSION_SCALED_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <cstdint>
+
+// How a column of integers encodes its values: value = raw * scale + offset
+struct ScaledEncoding {
+    double scale;
+    double offset;
+};
+
+// A scaled-integer column together with the range of its raw values, as
+// column statistics usually record it
+struct ScaledColumn {
+    std::int32_t* raw;
+    std::size_t count;
+    ScaledEncoding encoding;
+    std::int32_t rawMin;
+    std::int32_t rawMax;
+};
+
+// Converts the values of `column` into the target unit of conversion `id`.
+//
+// Usually only the metadata changes: the encoding is composed with the
+// conversion's affine map, so the untouched payload decodes straight into the
+// target unit, whatever the column's size. The values are validated through
+// the decoded extremes and throw like UnitConverter::convert().
+//
+// Clamping values beyond UnitConverter::clampLimit under ClampPolicy::Saturate
+// cannot be expressed in the encoding, so only then is the payload decoded,
+// converted and re-encoded in place with the new encoding, the clamped values
+// rounding to the nearest raw value. Returns false in that case.
+bool convertScaledColumn(const UnitConverter& converter, ConversionId id, ScaledColumn& column,
+                         ClampPolicy policy = ClampPolicy::Saturate);
+
+// Decodes `count` raw values with `from`, converts them like
+// UnitConverter::convertBatch() (throwing the same way) and encodes them
+// with `to`, rounding to the nearest raw value and saturating at the limits
+// of int32. `output` may alias `raw`. Returns how many values were beyond
+// clampLimit. Throws std::invalid_argument if `to` has a scale of 0.
+std::size_t reencodeScaledColumn(const UnitConverter& converter, ConversionId id, const std::int32_t* raw,
+                                 std::int32_t* output, std::size_t count, const ScaledEncoding& from,
+                                 const ScaledEncoding& to, ClampPolicy policy = ClampPolicy::Saturate);
+
+#endif // CONVERSION_SCALED_H
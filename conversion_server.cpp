@@ -0,0 +1,246 @@
+#include "conversion_server.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::system_error systemError(const char* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+ConversionServer::ConversionServer(const UnitConverter& converter, const std::string& socketPath)
+    : converter(converter), socketPath(socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is too long: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    try {
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) throw systemError("socket");
+        unlink(socketPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) throw systemError("bind");
+        if (listen(listenFd, SOMAXCONN) < 0) throw systemError("listen");
+
+        stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stopFd < 0) throw systemError("eventfd");
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) throw systemError("epoll_create1");
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0) throw systemError("epoll_ctl");
+        event.data.fd = stopFd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event) < 0) throw systemError("epoll_ctl");
+    } catch (...) {
+        if (epollFd >= 0) close(epollFd);
+        if (stopFd >= 0) close(stopFd);
+        if (listenFd >= 0) close(listenFd);
+        throw;
+    }
+}
+
+ConversionServer::~ConversionServer() {
+    for (const auto& entry : connections) close(entry.first);
+    close(epollFd);
+    close(stopFd);
+    close(listenFd);
+    unlink(socketPath.c_str());
+}
+
+void ConversionServer::stop() {
+    const std::uint64_t one = 1;
+    (void)!write(stopFd, &one, sizeof(one));
+}
+
+void ConversionServer::run() {
+    epoll_event events[64];
+    for (;;) {
+        const int ready = epoll_wait(epollFd, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw systemError("epoll_wait");
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == stopFd) {
+                std::uint64_t count;
+                (void)!read(stopFd, &count, sizeof(count));
+                return;
+            }
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = it->second;
+
+            // A client that shut down its end still gets the answers to the
+            // requests it sent before, then the connection is closed
+            bool healthy = !(events[i].events & EPOLLERR);
+            if (healthy && (events[i].events & (EPOLLIN | EPOLLHUP)) && wantsInput(connection)) {
+                healthy = readFrom(fd, connection);
+            }
+            // Requests held back by a full output buffer are answered as it
+            // drains; keep going while the socket takes everything
+            if (healthy) healthy = flush(fd, connection);
+            while (healthy) {
+                const std::size_t buffered = connection.input.size();
+                healthy = processRequests(connection) && flush(fd, connection);
+                if (!connection.output.empty() || connection.input.size() == buffered) break;
+            }
+            if (!healthy || (connection.peerClosed && connection.output.empty())) closeConnection(fd);
+        }
+    }
+}
+
+void ConversionServer::acceptConnections() {
+    for (;;) {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN, or a connection that went away before we got to it
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        connections[fd].interest = EPOLLIN;
+    }
+}
+
+// Whether to read more requests: not once the client has shut down its end,
+// nor while the buffers are full
+bool ConversionServer::wantsInput(const Connection& connection) const {
+    return !connection.peerClosed && connection.input.size() < maxBufferedInput &&
+           connection.output.size() - connection.outputOffset < outputHighWater;
+}
+
+// Drains the socket into the connection's input buffer, up to
+// maxBufferedInput. Returns false if the socket failed.
+bool ConversionServer::readFrom(int fd, Connection& connection) {
+    char buffer[64 * 1024];
+    while (connection.input.size() < maxBufferedInput) {
+        const std::size_t room = std::min(sizeof(buffer), maxBufferedInput - connection.input.size());
+        const ssize_t received = read(fd, buffer, room);
+        if (received > 0) {
+            connection.input.insert(connection.input.end(), buffer, buffer + received);
+            continue;
+        }
+        if (received == 0) {
+            connection.peerClosed = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+// Answers the complete requests in the input buffer, appending the responses
+// to the output buffer until it reaches outputHighWater. Returns false if the
+// client sent a malformed frame.
+bool ConversionServer::processRequests(Connection& connection) {
+    std::size_t offset = 0;
+    const std::size_t available = connection.input.size();
+
+    while (available - offset >= sizeof(RequestHeader) &&
+           connection.output.size() - connection.outputOffset < outputHighWater) {
+        RequestHeader request;
+        std::memcpy(&request, connection.input.data() + offset, sizeof(request));
+        if (request.count > maxValuesPerRequest) return false;
+
+        const std::size_t frameSize = sizeof(request) + request.typeLength + std::size_t(request.count) * sizeof(double);
+        if (available - offset < frameSize) break;
+
+        const char* payload = connection.input.data() + offset + sizeof(request);
+        const std::string type(payload, request.typeLength);
+        scratch.resize(request.count);
+        std::memcpy(scratch.data(), payload + request.typeLength, request.count * sizeof(double));
+
+        ResponseHeader response{request.requestId, ResponseHeader::Ok, request.count, 0};
+        std::string error;
+        try {
+            if (request.clampPolicy > static_cast<std::uint16_t>(ClampPolicy::PassThrough)) {
+                throw std::invalid_argument("Invalid clamp policy.");
+            }
+            response.clampedCount = static_cast<std::uint32_t>(converter.convertBatch(
+                type, scratch.data(), scratch.data(), scratch.size(), static_cast<ClampPolicy>(request.clampPolicy)));
+        } catch (const std::invalid_argument& e) {
+            error = e.what();
+            response.status = ResponseHeader::Error;
+            response.count = static_cast<std::uint32_t>(error.size());
+        }
+
+        const char* header = reinterpret_cast<const char*>(&response);
+        connection.output.insert(connection.output.end(), header, header + sizeof(response));
+        if (response.status == ResponseHeader::Ok) {
+            const char* values = reinterpret_cast<const char*>(scratch.data());
+            connection.output.insert(connection.output.end(), values, values + scratch.size() * sizeof(double));
+        } else {
+            connection.output.insert(connection.output.end(), error.begin(), error.end());
+        }
+        offset += frameSize;
+    }
+
+    connection.input.erase(connection.input.begin(), connection.input.begin() + offset);
+    return true;
+}
+
+// Writes as much pending output as the socket accepts, and only asks epoll
+// for EPOLLOUT while some is left over (and for EPOLLIN while wantsInput())
+bool ConversionServer::flush(int fd, Connection& connection) {
+    while (connection.outputOffset < connection.output.size()) {
+        const ssize_t sent = send(fd, connection.output.data() + connection.outputOffset,
+                                  connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (sent >= 0) {
+            connection.outputOffset += static_cast<std::size_t>(sent);
+            continue;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        break;
+    }
+
+    const bool pending = connection.outputOffset < connection.output.size();
+    if (!pending) {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    } else if (connection.outputOffset >= outputHighWater) {
+        // Drop what was sent, so a client that keeps reading a little at a
+        // time does not grow the buffer
+        connection.output.erase(connection.output.begin(), connection.output.begin() + connection.outputOffset);
+        connection.outputOffset = 0;
+    }
+    const std::uint32_t interest = (wantsInput(connection) ? std::uint32_t(EPOLLIN) : 0u) | (pending ? std::uint32_t(EPOLLOUT) : 0u);
+    if (interest != connection.interest) {
+        epoll_event event{};
+        event.events = interest;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) < 0) return false;
+        connection.interest = interest;
+    }
+    return true;
+}
+
+void ConversionServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
@@ -0,0 +1,86 @@
+#ifndef CONVERSION_SERVER_H
+#define CONVERSION_SERVER_H
+
+#include "unit_converter.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Wire format of the conversion server. All fields use the host byte order,
+// since clients always run on the same machine.
+//
+// A request is a RequestHeader followed by `typeLength` bytes of conversion
+// type (e.g. "KilometersToMiles") and `count` doubles. Clients may send any
+// number of requests without waiting; responses come back in request order.
+struct RequestHeader {
+    std::uint32_t requestId;   // echoed back in the response
+    std::uint16_t typeLength;
+    std::uint16_t clampPolicy; // a ClampPolicy value
+    std::uint32_t count;       // number of doubles that follow
+};
+
+// A response is a ResponseHeader followed by `count` converted doubles when
+// status is Ok, or by `count` bytes of error message otherwise.
+struct ResponseHeader {
+    enum Status : std::uint32_t { Ok = 0, Error = 1 };
+
+    std::uint32_t requestId;
+    std::uint32_t status;
+    std::uint32_t count;
+    std::uint32_t clampedCount; // inputs beyond UnitConverter::clampLimit
+};
+
+// Serves conversion requests over a Unix domain socket with a single epoll
+// loop, so one long-lived converter replaces a process spawn per value.
+class ConversionServer {
+private:
+    struct Connection {
+        std::vector<char> input;
+        std::vector<char> output;
+        std::size_t outputOffset = 0;
+        std::uint32_t interest = 0; // epoll events currently registered
+        bool peerClosed = false;
+    };
+
+    const UnitConverter& converter;
+    std::string socketPath;
+    int listenFd = -1;
+    int epollFd = -1;
+    int stopFd = -1;
+    std::unordered_map<int, Connection> connections;
+    std::vector<double> scratch;
+
+    void acceptConnections();
+    bool wantsInput(const Connection& connection) const;
+    bool readFrom(int fd, Connection& connection);
+    bool processRequests(Connection& connection);
+    bool flush(int fd, Connection& connection);
+    void closeConnection(int fd);
+
+public:
+    static constexpr std::uint32_t maxValuesPerRequest = 1u << 20;
+    // Input is buffered up to one frame of the largest size, which is then
+    // always complete
+    static constexpr std::size_t maxBufferedInput =
+        sizeof(RequestHeader) + 0xFFFF + std::size_t(maxValuesPerRequest) * sizeof(double);
+    // While more output than this waits for a client that pipelines requests
+    // without reading the responses, its requests are left unread
+    static constexpr std::size_t outputHighWater = 1u << 20;
+
+    // Binds and listens on `socketPath`, replacing any stale socket file.
+    // Throws std::system_error if the socket cannot be set up.
+    ConversionServer(const UnitConverter& converter, const std::string& socketPath);
+    ~ConversionServer();
+
+    ConversionServer(const ConversionServer&) = delete;
+    ConversionServer& operator=(const ConversionServer&) = delete;
+
+    // Serves requests until stop() is called
+    void run();
+
+    // Makes run() return; safe to call from another thread
+    void stop();
+};
+
+#endif // CONVERSION_SERVER_H
@@ -0,0 +1,120 @@
+#include "conversion_sketch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+static constexpr double pi = 3.14159265358979323846;
+
+QuantileSketch::QuantileSketch(const UnitConverter& converter, const std::string& sourceUnit, double compression)
+    : converter(converter), source(unitId(sourceUnit)), compression(std::max(compression, 10.0)),
+      minimum(std::numeric_limits<double>::infinity()), maximum(-std::numeric_limits<double>::infinity()) {
+    buffer.reserve(static_cast<std::size_t>(5 * this->compression));
+}
+
+void QuantileSketch::add(double value) {
+    if (std::isnan(value)) return;
+    buffer.push_back({value, 1.0});
+    pendingWeight += 1.0;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+    if (buffer.size() >= static_cast<std::size_t>(5 * compression)) flush();
+}
+
+void QuantileSketch::add(const double* values, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) add(values[i]);
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.source != source) {
+        throw std::invalid_argument(std::string("Cannot merge sketches of ") + unitInfo(other.source).name + " and " +
+                                    unitInfo(source).name + ".");
+    }
+    other.flush();
+    for (const Centroid& centroid : other.centroids) {
+        buffer.push_back(centroid);
+        pendingWeight += centroid.weight;
+    }
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    flush();
+}
+
+// Folds the buffer into the centroids: sorts everything by mean and merges
+// neighbours while the merged centroid stays within one unit of the k1 scale
+// function k(q) = compression / (2 pi) * asin(2q - 1), which keeps centroids
+// small near q = 0 and q = 1
+void QuantileSketch::flush() const {
+    if (buffer.empty()) return;
+    buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+    std::sort(buffer.begin(), buffer.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    const double total = totalWeight + pendingWeight;
+    const double normalizer = compression / (2.0 * pi);
+    auto weightLimit = [&](double weightSoFar) {
+        const double k = normalizer * std::asin(2.0 * std::min(1.0, weightSoFar / total) - 1.0) + 1.0;
+        const double q = k >= compression / 4.0 ? 1.0 : (std::sin(k / normalizer) + 1.0) / 2.0;
+        return total * q;
+    };
+
+    centroids.clear();
+    Centroid current = buffer.front();
+    double weightSoFar = 0.0;
+    double limit = weightLimit(0.0);
+    for (std::size_t i = 1; i < buffer.size(); ++i) {
+        const Centroid& next = buffer[i];
+        if (weightSoFar + current.weight + next.weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            weightSoFar += current.weight;
+            centroids.push_back(current);
+            limit = weightLimit(weightSoFar);
+            current = next;
+        }
+    }
+    centroids.push_back(current);
+
+    totalWeight = total;
+    pendingWeight = 0.0;
+    buffer.clear();
+}
+
+double QuantileSketch::quantile(double q) const {
+    flush();
+    if (centroids.empty()) return std::numeric_limits<double>::quiet_NaN();
+    q = std::clamp(q, 0.0, 1.0);
+    if (q == 0.0) return minimum;
+    if (q == 1.0) return maximum;
+    if (centroids.size() == 1) return centroids.front().mean;
+
+    // Each centroid's weight is centred on its mean; interpolate between the
+    // centres, and between the outer centres and the extremes
+    const double index = q * totalWeight;
+    const Centroid& first = centroids.front();
+    if (index < first.weight / 2.0) {
+        return minimum + (first.mean - minimum) * index / (first.weight / 2.0);
+    }
+    double cumulative = first.weight / 2.0;
+    for (std::size_t i = 0; i + 1 < centroids.size(); ++i) {
+        const double step = (centroids[i].weight + centroids[i + 1].weight) / 2.0;
+        if (cumulative + step > index) {
+            const double t = (index - cumulative) / step;
+            return centroids[i].mean + (centroids[i + 1].mean - centroids[i].mean) * t;
+        }
+        cumulative += step;
+    }
+    const Centroid& last = centroids.back();
+    const double t = std::min(1.0, (index - cumulative) / (last.weight / 2.0));
+    return last.mean + (maximum - last.mean) * t;
+}
+
+double QuantileSketch::quantile(double q, UnitId targetUnit, ClampPolicy policy) const {
+    const double value = quantile(q);
+    if (std::isnan(value)) return value;
+    return converter.convert(source, targetUnit, value, policy);
+}
+
+double QuantileSketch::quantile(double q, const std::string& targetUnit, ClampPolicy policy) const {
+    return quantile(q, unitId(targetUnit), policy);
+}
@@ -0,0 +1,62 @@
+#ifndef CONVERSION_SKETCH_H
+#define CONVERSION_SKETCH_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Streaming quantile sketch (a merging t-digest) over values in one source
+// unit that answers quantiles in any unit of the same dimension. Unit
+// conversions are increasing affine maps, so the source quantile is found
+// first and only that one value is converted; added values are never
+// converted one by one.
+//
+// Memory stays around `compression` centroids whatever the number of values.
+// Quantiles are most accurate near the tails (p1, p99), which is where the
+// centroids are kept smallest.
+class QuantileSketch {
+public:
+    // Throws std::invalid_argument for unknown units
+    QuantileSketch(const UnitConverter& converter, const std::string& sourceUnit, double compression = 100.0);
+
+    // Values are not validated when added; NaNs are ignored
+    void add(double value);
+    void add(const double* values, std::size_t count);
+    // Adds everything `other` has seen; it must have the same source unit
+    void merge(const QuantileSketch& other);
+
+    std::size_t count() const { return static_cast<std::size_t>(totalWeight + pendingWeight); }
+
+    // Estimated q-quantile (0 <= q <= 1) in the source unit; NaN while empty
+    double quantile(double q) const;
+    // The same converted to `targetUnit`, validated and clamped like
+    // UnitConverter::convert(), which throws the same way
+    double quantile(double q, UnitId targetUnit, ClampPolicy policy = ClampPolicy::Saturate) const;
+    double quantile(double q, const std::string& targetUnit, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    UnitId sourceUnit() const { return source; }
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    const UnitConverter& converter;
+    UnitId source;
+    double compression;
+    // Values (and merged centroids) are buffered and folded into the
+    // centroids in sorted batches. Queries fold pending ones in too, hence
+    // mutable.
+    mutable std::vector<Centroid> centroids;
+    mutable std::vector<Centroid> buffer;
+    mutable double totalWeight = 0.0;
+    mutable double pendingWeight = 0.0;
+    double minimum;
+    double maximum;
+
+    void flush() const;
+};
+
+#endif // CONVERSION_SKETCH_H
@@ -0,0 +1,60 @@
+#include "conversion_strided.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Records are prefetched this many ahead of the one being gathered, far
+// enough to hide a memory access behind the loads in between
+static constexpr std::size_t prefetchDistance = 16;
+
+static void prefetch(const unsigned char* address, bool forWrite) {
+#if defined(__GNUC__)
+    if (forWrite) {
+        __builtin_prefetch(address, 1);
+    } else {
+        __builtin_prefetch(address, 0);
+    }
+#else
+    (void)address;
+    (void)forWrite;
+#endif
+}
+
+std::size_t convertStrided(const UnitConverter& converter, ConversionId id, void* values, std::size_t stride,
+                           std::size_t count, ClampPolicy policy) {
+    return convertStrided(converter, id, values, stride, values, stride, count, policy);
+}
+
+std::size_t convertStrided(const UnitConverter& converter, ConversionId id, const void* input,
+                           std::size_t inputStride, void* output, std::size_t outputStride, std::size_t count,
+                           ClampPolicy policy) {
+    const auto* in = static_cast<const unsigned char*>(input);
+    auto* out = static_cast<unsigned char*>(output);
+    // Packed, aligned doubles need no gathering
+    const bool aligned = (reinterpret_cast<std::uintptr_t>(input) | reinterpret_cast<std::uintptr_t>(output)) %
+                             alignof(double) == 0;
+    if (inputStride == sizeof(double) && outputStride == sizeof(double) && aligned) {
+        return converter.convertBatch(id, static_cast<const double*>(input), static_cast<double*>(output), count,
+                                      policy);
+    }
+
+    // The chunk stays in L1 between the gather and the scatter; in place,
+    // so do the records it came from
+    constexpr std::size_t chunkSize = 256;
+    double values[chunkSize];
+    std::size_t outOfRange = 0;
+    for (std::size_t start = 0; start < count; start += chunkSize) {
+        const std::size_t n = std::min(chunkSize, count - start);
+        for (std::size_t i = start; i < start + n; ++i) {
+            const std::size_t ahead = std::min(i + prefetchDistance, count - 1);
+            prefetch(in + ahead * inputStride, false);
+            if (out != in) prefetch(out + ahead * outputStride, true);
+            std::memcpy(&values[i - start], in + i * inputStride, sizeof(double));
+        }
+        outOfRange += converter.convertBatch(id, values, values, n, policy);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::memcpy(out + (start + i) * outputStride, &values[i], sizeof(double));
+        }
+    }
+    return outOfRange;
+}
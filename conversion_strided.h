@@ -0,0 +1,44 @@
+#ifndef CONVERSION_STRIDED_H
+#define CONVERSION_STRIDED_H
+
+#include "unit_converter.h"
+#include <cstddef>
+#include <string>
+
+// Converts `count` doubles spaced `stride` bytes apart, starting at `values`,
+// in place: one field of an array of records such as
+// {timestamp, sensorId, value, flags}, leaving the other fields untouched.
+// The values are gathered into a contiguous chunk (prefetching records
+// ahead), converted with the vectorized batch kernel and scattered back.
+// They need not be aligned. Validates, clamps, returns and throws like
+// UnitConverter::convertBatch(), one chunk at a time: each gathered chunk is
+// validated before it is written back, so after a throw the failing chunk
+// and those after it are untouched, but earlier ones may already be
+// converted. Packed, aligned doubles go straight to convertBatch() and are
+// left as it leaves them.
+std::size_t convertStrided(const UnitConverter& converter, ConversionId id, void* values, std::size_t stride,
+                           std::size_t count, ClampPolicy policy = ClampPolicy::Saturate);
+// The same from one strided sequence into another, e.g. a field of the
+// input records into a field of the output ones. They may be the same
+// sequence, but must not overlap otherwise.
+std::size_t convertStrided(const UnitConverter& converter, ConversionId id, const void* input,
+                           std::size_t inputStride, void* output, std::size_t outputStride, std::size_t count,
+                           ClampPolicy policy = ClampPolicy::Saturate);
+
+// Converts the `field` member of `count` records in place:
+//
+//     convertField(converter, id, readings.data(), readings.size(), &Reading::value);
+template <typename Record>
+std::size_t convertField(const UnitConverter& converter, ConversionId id, Record* records, std::size_t count,
+                         double Record::*field, ClampPolicy policy = ClampPolicy::Saturate) {
+    if (count == 0) return 0;
+    return convertStrided(converter, id, &(records->*field), sizeof(Record), count, policy);
+}
+
+template <typename Record>
+std::size_t convertField(const UnitConverter& converter, const std::string& conversionType, Record* records,
+                         std::size_t count, double Record::*field, ClampPolicy policy = ClampPolicy::Saturate) {
+    return convertField(converter, converter.conversionId(conversionType), records, count, field, policy);
+}
+
+#endif // CONVERSION_STRIDED_H
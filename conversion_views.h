@@ -0,0 +1,72 @@
+#ifndef CONVERSION_VIEWS_H
+#define CONVERSION_VIEWS_H
+
+#include "unit_converter.h"
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Lazy converted views for std::ranges:
+//
+//     for (double miles : distances | views::convert(converter, "KilometersToMiles")) ...
+//
+// Each element is converted when it is read, so nothing is allocated up
+// front and elements that are never read are never converted. Invalid
+// elements throw std::invalid_argument when read. The view keeps the category
+// of the underlying range (random access stays random access), and lvalue
+// ranges of contiguous doubles are viewed through a std::span, so their
+// iterators are plain pointers underneath.
+//
+// The conversion is captured once as a UnitConverter::ElementConversion and
+// applied inline: reading an element is a validation check, a clamp and the
+// conversion's arithmetic, with no call into the converter. Results match
+// UnitConverter::convert() but bypass its result cache.
+namespace views {
+
+// Range adaptor closure returned by views::convert()
+class ConvertClosure {
+public:
+    explicit ConvertClosure(UnitConverter::ElementConversion element) : element(element) {}
+
+    template <std::ranges::viewable_range Range>
+        requires std::convertible_to<std::ranges::range_reference_t<Range>, double>
+    auto operator()(Range&& range) const {
+        if constexpr (std::ranges::contiguous_range<Range> && std::ranges::sized_range<Range> &&
+                      std::ranges::borrowed_range<Range> &&
+                      std::same_as<std::ranges::range_value_t<Range>, double>) {
+            return std::views::transform(std::span<const double>(std::ranges::data(range), std::ranges::size(range)),
+                                         element);
+        } else {
+            return std::views::transform(std::forward<Range>(range), element);
+        }
+    }
+
+    template <std::ranges::viewable_range Range>
+        requires std::convertible_to<std::ranges::range_reference_t<Range>, double>
+    friend auto operator|(Range&& range, const ConvertClosure& closure) {
+        return closure(std::forward<Range>(range));
+    }
+
+private:
+    UnitConverter::ElementConversion element;
+};
+
+// The views do not refer to the converter once created. The name-based
+// overload throws std::invalid_argument right away unless the name is a
+// conversion between two units of one dimension.
+inline ConvertClosure convert(const UnitConverter& converter, ConversionId id,
+                              ClampPolicy policy = ClampPolicy::Saturate) {
+    return ConvertClosure(converter.elementConversion(id, policy));
+}
+
+inline ConvertClosure convert(const UnitConverter& converter, const std::string& conversionType,
+                              ClampPolicy policy = ClampPolicy::Saturate) {
+    return ConvertClosure(converter.elementConversion(converter.conversionId(conversionType), policy));
+}
+
+} // namespace views
+
+#endif // CONVERSION_VIEWS_H
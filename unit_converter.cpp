@@ -1,42 +1,506 @@
 #include "unit_converter.h"
+#include "conversion_server.h"
+#include "conversion_ring.h"
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <stdexcept>
 #include <limits>    // for std::numeric_limits
 #include <cctype>    // for std::isdigit
 #include <string>
-#include <algorithm> // for std::find, std::transform
+#include <string_view>
+#include <algorithm> // for std::find, std::transform, std::min, std::max
+#include <cstdio>    // for the one-shot command-line mode
+#include <cstdlib>   // for std::strtod
+#include <cerrno>    // for errno
+#include <cstring>   // for std::strcmp
+#include <iterator>  // for std::size
+#include <cmath>     // for std::fma
+#include <atomic>    // for numbering converter instances
+#include <array>     // for the unit lookup's compile-time seed search
+#include <thread>    // for parallel summaries
+
+// A registered conversion. The tables below are plain static data, copied
+// into each converter when it is built.
+struct ConversionEntry {
+    const char* name;
+    const char* from;
+    const char* to;
+    double scale;   // converts to x * scale + offset, up to rounding
+    double offset;
+    double shift;   // exactly (x + shift) / divisor if divisor is non-zero,
+    double divisor; // else exactly x * scale + offset
+};
+
+// Exact definitions of the non-SI units. Each pair of conversions is derived
+// from one of these constants: one direction multiplies by it and the other
+// divides by it, each rounding correctly, so results are reproducible. A
+// round trip still rounds twice. It returns x exactly only when the
+// intermediate result is exact (e.g. 1.609344 km is 1 mile); otherwise it
+// lands within one ulp of x, since no pair of correctly rounded directions
+// can invert each other for every double.
+static constexpr double fahrenheitPerCelsius = 1.8;
+static constexpr double kelvinAtZeroCelsius = 273.15;
+static constexpr double kilometersPerMile = 1.609344;
+static constexpr double metersPerFoot = 0.3048;
+static constexpr double kilogramsPerPound = 0.45359237;
+static constexpr double gramsPerOunce = 28.349523125;
+static constexpr double litersPerGallon = 3.785411784;
+static constexpr double millilitersPerFluidOunce = 29.5735295625;
+static constexpr double minutesPerHour = 60.0;
+
+// Reciprocals, rounded once at compile time
+static constexpr double celsiusPerFahrenheit = 1.0 / fahrenheitPerCelsius;
+static constexpr double milesPerKilometer = 1.0 / kilometersPerMile;
+static constexpr double feetPerMeter = 1.0 / metersPerFoot;
+static constexpr double poundsPerKilogram = 1.0 / kilogramsPerPound;
+static constexpr double ouncesPerGram = 1.0 / gramsPerOunce;
+static constexpr double gallonsPerLiter = 1.0 / litersPerGallon;
+static constexpr double fluidOuncesPerMilliliter = 1.0 / millilitersPerFluidOunce;
+
+static const ConversionEntry temperatureConversions[] = {
+    {"CelsiusToFahrenheit", "Celsius", "Fahrenheit", fahrenheitPerCelsius, 32.0, 0.0, 0.0},
+    {"FahrenheitToCelsius", "Fahrenheit", "Celsius", celsiusPerFahrenheit, -32.0 * celsiusPerFahrenheit,
+     -32.0, fahrenheitPerCelsius},
+    {"CelsiusToKelvin", "Celsius", "Kelvin", 1.0, kelvinAtZeroCelsius, 0.0, 0.0},
+    {"KelvinToCelsius", "Kelvin", "Celsius", 1.0, -kelvinAtZeroCelsius, 0.0, 0.0},
+};
+
+static const ConversionEntry distanceConversions[] = {
+    {"KilometersToMiles", "Kilometers", "Miles", milesPerKilometer, 0.0, 0.0, kilometersPerMile},
+    {"MilesToKilometers", "Miles", "Kilometers", kilometersPerMile, 0.0, 0.0, 0.0},
+    {"MetersToFeet", "Meters", "Feet", feetPerMeter, 0.0, 0.0, metersPerFoot},
+    {"FeetToMeters", "Feet", "Meters", metersPerFoot, 0.0, 0.0, 0.0},
+};
+
+static const ConversionEntry weightConversions[] = {
+    {"KilogramsToPounds", "Kilograms", "Pounds", poundsPerKilogram, 0.0, 0.0, kilogramsPerPound},
+    {"PoundsToKilograms", "Pounds", "Kilograms", kilogramsPerPound, 0.0, 0.0, 0.0},
+    {"GramsToOunces", "Grams", "Ounces", ouncesPerGram, 0.0, 0.0, gramsPerOunce},
+    {"OuncesToGrams", "Ounces", "Grams", gramsPerOunce, 0.0, 0.0, 0.0},
+};
+
+static const ConversionEntry volumeConversions[] = {
+    {"LitersToGallons", "Liters", "Gallons", gallonsPerLiter, 0.0, 0.0, litersPerGallon},
+    {"GallonsToLiters", "Gallons", "Liters", litersPerGallon, 0.0, 0.0, 0.0},
+    {"MillilitersToFluidOunces", "Milliliters", "FluidOunces", fluidOuncesPerMilliliter, 0.0, 0.0, millilitersPerFluidOunce},
+    {"FluidOuncesToMilliliters", "FluidOunces", "Milliliters", millilitersPerFluidOunce, 0.0, 0.0, 0.0},
+};
+
+// A conversion between rates or ratios of base units, such as kilometers per
+// hour. Its factor is worked out at registration from the factors of the base
+// conversions: numerator / denominator * timeScale.
+struct CompoundEntry {
+    const char* name;
+    const char* from;
+    const char* to;
+    const char* numerator;   // base conversion of the numerator unit
+    const char* denominator; // base conversion of the denominator unit, nullptr for time
+    double timeScale;        // source time units per target time unit
+};
+
+static const CompoundEntry speedConversions[] = {
+    {"KilometersPerHourToMilesPerHour", "KilometersPerHour", "MilesPerHour", "KilometersToMiles", nullptr, 1.0},
+    {"MilesPerHourToKilometersPerHour", "MilesPerHour", "KilometersPerHour", "MilesToKilometers", nullptr, 1.0},
+};
+
+static const CompoundEntry densityConversions[] = {
+    {"KilogramsPerLiterToPoundsPerGallon", "KilogramsPerLiter", "PoundsPerGallon", "KilogramsToPounds", "LitersToGallons", 1.0},
+    {"PoundsPerGallonToKilogramsPerLiter", "PoundsPerGallon", "KilogramsPerLiter", "PoundsToKilograms", "GallonsToLiters", 1.0},
+};
+
+static const CompoundEntry flowRateConversions[] = {
+    {"LitersPerMinuteToGallonsPerHour", "LitersPerMinute", "GallonsPerHour", "LitersToGallons", nullptr, minutesPerHour},
+    {"GallonsPerHourToLitersPerMinute", "GallonsPerHour", "LitersPerMinute", "GallonsToLiters", nullptr, 1.0 / minutesPerHour},
+};
+
+struct ConversionTable {
+    CategoryInfo info;
+    const ConversionEntry* entries;
+    std::size_t size;
+};
+
+struct CompoundTable {
+    CategoryInfo info;
+    const CompoundEntry* entries;
+    std::size_t size;
+};
+
+static const ConversionTable conversionTables[] = {
+    {{Category::Temperature, "Temperature", Dimension::Temperature}, temperatureConversions, std::size(temperatureConversions)},
+    {{Category::Distance, "Distance", Dimension::Length}, distanceConversions, std::size(distanceConversions)},
+    {{Category::Weight, "Weight", Dimension::Mass}, weightConversions, std::size(weightConversions)},
+    {{Category::Volume, "Volume", Dimension::Volume}, volumeConversions, std::size(volumeConversions)},
+};
+
+static const CompoundTable compoundTables[] = {
+    {{Category::Speed, "Speed", Dimension::Speed}, speedConversions, std::size(speedConversions)},
+    {{Category::Density, "Density", Dimension::Density}, densityConversions, std::size(densityConversions)},
+    {{Category::FlowRate, "Flow Rate", Dimension::FlowRate}, flowRateConversions, std::size(flowRateConversions)},
+};
+
+// Every unit, relative to the first unit of its dimension (the base unit):
+// base = (value + shift) * num / den. Inputs whose base value is below
+// `minimum` are rejected with `message`.
+struct UnitEntry {
+    UnitInfo info;
+    double shift;
+    double num;
+    double den;
+    double minimum;
+    const char* message;
+};
+
+static constexpr const char* belowAbsoluteZero = "Temperature value below absolute zero is not valid.";
+static constexpr const char* negativeDistance = "Negative distance values are not valid.";
+static constexpr const char* negativeWeight = "Negative weight values are not valid.";
+static constexpr const char* negativeVolume = "Negative volume values are not valid.";
+static constexpr const char* negativeSpeed = "Negative speed values are not valid.";
+static constexpr const char* negativeDensity = "Negative density values are not valid.";
+static constexpr const char* negativeFlowRate = "Negative flow rate values are not valid.";
+
+static constexpr UnitEntry units[] = {
+    {{"Celsius", "°C", Dimension::Temperature}, 0.0, 1.0, 1.0, -kelvinAtZeroCelsius, belowAbsoluteZero},
+    {{"Fahrenheit", "°F", Dimension::Temperature}, -32.0, 5.0, 9.0, -kelvinAtZeroCelsius, belowAbsoluteZero},
+    {{"Kelvin", "K", Dimension::Temperature}, -kelvinAtZeroCelsius, 1.0, 1.0, -kelvinAtZeroCelsius, belowAbsoluteZero},
+    {{"Kilometers", "km", Dimension::Length}, 0.0, 1.0, 1.0, 0.0, negativeDistance},
+    {{"Miles", "mi", Dimension::Length}, 0.0, kilometersPerMile, 1.0, 0.0, negativeDistance},
+    {{"Meters", "m", Dimension::Length}, 0.0, 1.0, 1000.0, 0.0, negativeDistance},
+    {{"Feet", "ft", Dimension::Length}, 0.0, metersPerFoot, 1000.0, 0.0, negativeDistance},
+    {{"Kilograms", "kg", Dimension::Mass}, 0.0, 1.0, 1.0, 0.0, negativeWeight},
+    {{"Pounds", "lb", Dimension::Mass}, 0.0, kilogramsPerPound, 1.0, 0.0, negativeWeight},
+    {{"Grams", "g", Dimension::Mass}, 0.0, 1.0, 1000.0, 0.0, negativeWeight},
+    {{"Ounces", "oz", Dimension::Mass}, 0.0, gramsPerOunce, 1000.0, 0.0, negativeWeight},
+    {{"Liters", "L", Dimension::Volume}, 0.0, 1.0, 1.0, 0.0, negativeVolume},
+    {{"Gallons", "gal", Dimension::Volume}, 0.0, litersPerGallon, 1.0, 0.0, negativeVolume},
+    {{"Milliliters", "mL", Dimension::Volume}, 0.0, 1.0, 1000.0, 0.0, negativeVolume},
+    {{"FluidOunces", "fl oz", Dimension::Volume}, 0.0, millilitersPerFluidOunce, 1000.0, 0.0, negativeVolume},
+    {{"KilometersPerHour", "km/h", Dimension::Speed}, 0.0, 1.0, 1.0, 0.0, negativeSpeed},
+    {{"MilesPerHour", "mph", Dimension::Speed}, 0.0, kilometersPerMile, 1.0, 0.0, negativeSpeed},
+    {{"KilogramsPerLiter", "kg/L", Dimension::Density}, 0.0, 1.0, 1.0, 0.0, negativeDensity},
+    {{"PoundsPerGallon", "lb/gal", Dimension::Density}, 0.0, kilogramsPerPound, litersPerGallon, 0.0, negativeDensity},
+    {{"LitersPerMinute", "L/min", Dimension::FlowRate}, 0.0, 1.0, 1.0, 0.0, negativeFlowRate},
+    {{"GallonsPerHour", "gal/h", Dimension::FlowRate}, 0.0, litersPerGallon, minutesPerHour, 0.0, negativeFlowRate},
+};
+
+// Spellings accepted besides each unit's name and symbol, matched ignoring case
+static constexpr UnitAlias unitAliases[] = {
+    {"C", "Celsius"}, {"degC", "Celsius"}, {"deg C", "Celsius"}, {"degrees C", "Celsius"},
+    {"degrees Celsius", "Celsius"},
+    {"F", "Fahrenheit"}, {"degF", "Fahrenheit"}, {"deg F", "Fahrenheit"}, {"degrees F", "Fahrenheit"},
+    {"degrees Fahrenheit", "Fahrenheit"},
+    {"kelvins", "Kelvin"},
+    {"kilometer", "Kilometers"}, {"kilometre", "Kilometers"}, {"kilometres", "Kilometers"}, {"kms", "Kilometers"},
+    {"mile", "Miles"},
+    {"meter", "Meters"}, {"metre", "Meters"}, {"metres", "Meters"},
+    {"foot", "Feet"}, {"'", "Feet"},
+    {"kilogram", "Kilograms"}, {"kgs", "Kilograms"}, {"kilo", "Kilograms"}, {"kilos", "Kilograms"},
+    {"pound", "Pounds"}, {"lbs", "Pounds"},
+    {"gram", "Grams"},
+    {"ounce", "Ounces"},
+    {"liter", "Liters"}, {"litre", "Liters"}, {"litres", "Liters"}, {"l.", "Liters"},
+    {"gallon", "Gallons"}, {"gals", "Gallons"},
+    {"milliliter", "Milliliters"}, {"millilitre", "Milliliters"}, {"millilitres", "Milliliters"},
+    {"ml.", "Milliliters"},
+    {"fluid ounce", "FluidOunces"}, {"fluid ounces", "FluidOunces"}, {"floz", "FluidOunces"},
+    {"fl. oz", "FluidOunces"}, {"fl.oz", "FluidOunces"}, {"fl oz.", "FluidOunces"},
+    {"kph", "KilometersPerHour"}, {"kmh", "KilometersPerHour"}, {"km/hr", "KilometersPerHour"},
+    {"kilometers per hour", "KilometersPerHour"},
+    {"mi/h", "MilesPerHour"}, {"miles per hour", "MilesPerHour"},
+    {"lbs/gal", "PoundsPerGallon"},
+    {"lpm", "LitersPerMinute"}, {"l/m", "LitersPerMinute"}, {"liters per minute", "LitersPerMinute"},
+    {"gph", "GallonsPerHour"}, {"gal/hr", "GallonsPerHour"}, {"gallons per hour", "GallonsPerHour"},
+};
+
+// Scans the static tables for a conversion; returns nullptr if there is none
+static const ConversionEntry* findConversionEntry(const char* name) {
+    for (const auto& table : conversionTables) {
+        for (std::size_t i = 0; i < table.size; ++i) {
+            if (std::strcmp(table.entries[i].name, name) == 0) return &table.entries[i];
+        }
+    }
+    return nullptr;
+}
+
+static constexpr char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static constexpr bool equalIgnoringCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (foldCase(a[i]) != foldCase(b[i])) return false;
+    }
+    return true;
+}
+
+// Perfect hash from every spelling of a unit (name, symbol or alias, in any
+// ASCII case) to its index in the unit table. The seed is searched at compile
+// time so that no two spellings share a slot; a lookup then hashes the folded
+// bytes, loads one slot of a table also built at compile time and compares
+// one key, without allocating.
+static constexpr std::size_t unitSlotCount = 4096;
+
+// FNV-1a over the case-folded bytes, with the high bits folded down
+static constexpr std::size_t unitSlotOf(std::string_view text, std::uint64_t seed) {
+    std::uint64_t hash = seed;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(foldCase(c));
+        hash *= 0x100000001B3ull;
+    }
+    return static_cast<std::size_t>(hash ^ (hash >> 29)) & (unitSlotCount - 1);
+}
+
+// First seed in a fixed sequence under which only spellings that are equal
+// ignoring case share a slot, or 0 if none of the first 1000 works
+static constexpr std::uint64_t findUnitLookupSeed() {
+    std::array<std::string_view, 2 * std::size(units) + std::size(unitAliases)> spellings{};
+    std::size_t count = 0;
+    for (const auto& unit : units) {
+        spellings[count++] = unit.info.name;
+        spellings[count++] = unit.info.symbol;
+    }
+    for (const auto& alias : unitAliases) spellings[count++] = alias.alias;
+
+    std::uint64_t seed = 0xCBF29CE484222325ull;
+    for (int attempt = 0; attempt < 1000; ++attempt, seed = seed * 0x9E3779B97F4A7C15ull + 1) {
+        std::array<std::size_t, unitSlotCount> slots{}; // index of the spelling + 1, 0 if empty
+        bool collided = false;
+        for (std::size_t i = 0; i < count && !collided; ++i) {
+            std::size_t& slot = slots[unitSlotOf(spellings[i], seed)];
+            collided = slot != 0 && !equalIgnoringCase(spellings[slot - 1], spellings[i]);
+            if (slot == 0) slot = i + 1;
+        }
+        if (!collided) return seed;
+    }
+    return 0;
+}
+
+static constexpr std::uint64_t unitLookupSeed = findUnitLookupSeed();
+static_assert(unitLookupSeed != 0, "no collision-free unit lookup seed; raise unitSlotCount");
+
+struct UnitSlot {
+    const char* key = nullptr;
+    std::int16_t unit = -1;
+};
+
+static constexpr int findUnitIndexExact(std::string_view name) {
+    for (std::size_t i = 0; i < std::size(units); ++i) {
+        if (units[i].info.name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Spellings equal ignoring case keep the first unit listed
+static constexpr std::array<UnitSlot, unitSlotCount> buildUnitSlots() {
+    std::array<UnitSlot, unitSlotCount> slots{};
+    auto add = [&slots](const char* key, int unit) {
+        UnitSlot& slot = slots[unitSlotOf(key, unitLookupSeed)];
+        if (!slot.key) slot = {key, static_cast<std::int16_t>(unit)};
+    };
+    for (std::size_t unit = 0; unit < std::size(units); ++unit) {
+        add(units[unit].info.name, static_cast<int>(unit));
+        add(units[unit].info.symbol, static_cast<int>(unit));
+    }
+    for (const auto& alias : unitAliases) add(alias.alias, findUnitIndexExact(alias.unit));
+    return slots;
+}
+
+static constexpr std::array<UnitSlot, unitSlotCount> unitSlots = buildUnitSlots();
+
+// Index in the unit table of the unit spelled `name`, or -1
+static int findUnitIndex(std::string_view name) {
+    const UnitSlot& slot = unitSlots[unitSlotOf(name, unitLookupSeed)];
+    return slot.key && equalIgnoringCase(slot.key, name) ? slot.unit : -1;
+}
+
+// Splits "<Unit>To<Unit>" (the separator in any case) into the two units;
+// returns false if it is not of that form. Unit spellings never contain
+// "to", but every split is tried to be safe.
+static bool splitConversionName(std::string_view name, UnitId& from, UnitId& to) {
+    for (std::size_t at = 1; at + 2 < name.size(); ++at) {
+        if (foldCase(name[at]) != 't' || foldCase(name[at + 1]) != 'o') continue;
+        const int source = findUnitIndex(name.substr(0, at));
+        const int target = source < 0 ? -1 : findUnitIndex(name.substr(at + 2));
+        if (target >= 0) {
+            from = static_cast<UnitId>(source);
+            to = static_cast<UnitId>(target);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Multiplier of a compound conversion, from the factors of its base conversions
+static double compoundScale(const CompoundEntry& entry) {
+    double scale = findConversionEntry(entry.numerator)->scale * entry.timeScale;
+    if (entry.denominator) scale /= findConversionEntry(entry.denominator)->scale;
+    return scale;
+}
+
+std::vector<CategoryInfo> listCategories() {
+    std::vector<CategoryInfo> categories;
+    for (const auto& table : conversionTables) categories.push_back(table.info);
+    for (const auto& table : compoundTables) categories.push_back(table.info);
+    return categories;
+}
+
+std::vector<ConversionInfo> listConversions() {
+    std::vector<ConversionInfo> conversions;
+    for (const auto& table : conversionTables) {
+        for (std::size_t i = 0; i < table.size; ++i) {
+            const ConversionEntry& entry = table.entries[i];
+            conversions.push_back({entry.name, entry.from, entry.to, table.info.category});
+        }
+    }
+    for (const auto& table : compoundTables) {
+        for (std::size_t i = 0; i < table.size; ++i) {
+            const CompoundEntry& entry = table.entries[i];
+            conversions.push_back({entry.name, entry.from, entry.to, table.info.category});
+        }
+    }
+    return conversions;
+}
+
+std::vector<ConversionInfo> listConversions(Category category) {
+    std::vector<ConversionInfo> conversions;
+    for (const auto& info : listConversions()) {
+        if (info.category == category) conversions.push_back(info);
+    }
+    return conversions;
+}
+
+std::vector<UnitInfo> unitsOf(Dimension dimension) {
+    std::vector<UnitInfo> matching;
+    for (const auto& unit : units) {
+        if (unit.info.dimension == dimension) matching.push_back(unit.info);
+    }
+    return matching;
+}
+
+const UnitInfo* findUnit(std::string_view name) {
+    const int index = findUnitIndex(name);
+    return index < 0 ? nullptr : &units[index].info;
+}
+
+std::vector<UnitAlias> listUnitAliases() {
+    return std::vector<UnitAlias>(std::begin(unitAliases), std::end(unitAliases));
+}
+
+UnitId unitId(std::string_view name) {
+    const int index = findUnitIndex(name);
+    if (index < 0) throw std::invalid_argument("Unknown unit: " + std::string(name));
+    return static_cast<UnitId>(index);
+}
+
+const UnitInfo& unitInfo(UnitId id) {
+    if (id >= std::size(units)) throw std::out_of_range("Unknown unit id");
+    return units[id].info;
+}
+
+std::size_t unitCount() {
+    return std::size(units);
+}
+
+UnitConverter::ValidationRule UnitConverter::unitRule(UnitId unit) {
+    const UnitEntry& entry = units[unit];
+    return {entry.shift, entry.num, entry.den, entry.minimum, entry.message};
+}
+
+// Affine coefficients of the conversion between two units of one dimension:
+// into the base unit from `from`, then out of it into `to`
+static void unitPairCoefficients(const UnitEntry& from, const UnitEntry& to, double& scale, double& offset) {
+    // ((x + from.shift) * from.num / from.den) * to.den / to.num - to.shift
+    scale = (from.num * to.den) / (from.den * to.num);
+    offset = from.shift * scale - to.shift;
+}
+
+// Lays out one dense table per dimension and fills every pair with the affine
+// coefficients composed from the unit table
+void UnitConverter::buildUnitPairs() {
+    const std::size_t count = std::size(units);
+    pairRows.assign(count, 0);
+    pairColumns.assign(count, 0);
+    unitRules.clear();
+    for (std::size_t unit = 0; unit < count; ++unit) unitRules.push_back(unitRule(static_cast<UnitId>(unit)));
+
+    std::vector<bool> placed(count, false);
+    for (std::size_t first = 0; first < count; ++first) {
+        if (placed[first]) continue;
+        std::vector<std::size_t> members;
+        for (std::size_t unit = first; unit < count; ++unit) {
+            if (units[unit].info.dimension == units[first].info.dimension) {
+                pairColumns[unit] = members.size();
+                members.push_back(unit);
+                placed[unit] = true;
+            }
+        }
+
+        const std::size_t start = pairs.size();
+        for (std::size_t row = 0; row < members.size(); ++row) {
+            const UnitEntry& from = units[members[row]];
+            pairRows[members[row]] = start + row * members.size();
+            for (std::size_t column = 0; column < members.size(); ++column) {
+                double scale, offset;
+                unitPairCoefficients(from, units[members[column]], scale, offset);
+                pairs.push_back({scale, offset, noConversion, static_cast<UnitId>(members[row]),
+                                 static_cast<UnitId>(members[column])});
+            }
+        }
+    }
+}
+
+const UnitConverter::UnitPair* UnitConverter::findPair(UnitId from, UnitId to) const {
+    if (from >= pairRows.size() || to >= pairRows.size() ||
+        units[from].info.dimension != units[to].info.dimension) {
+        return nullptr;
+    }
+    return &pairs[pairRows[from] + pairColumns[to]];
+}
+
+const UnitConverter::UnitPair* UnitConverter::findPair(std::string_view conversionType) const {
+    UnitId from, to;
+    return splitConversionName(conversionType, from, to) ? findPair(from, to) : nullptr;
+}
+
+void UnitConverter::registerConversion(const std::string& name, double scale, double offset, double shift,
+                                       double divisor) {
+    UnitId from, to;
+    if (!splitConversionName(name, from, to) || !findPair(from, to)) {
+        throw std::invalid_argument("Invalid conversion type: " + name);
+    }
+    pairs[pairRows[from] + pairColumns[to]].conversion = static_cast<ConversionId>(conversions.size());
+    conversions.push_back({unitRules[from], scale, offset, shift, divisor, from, to});
+}
 
 // Registers temperature conversions
 void UnitConverter::registerTemperatureConversions() {
-    conversionFunctions["CelsiusToFahrenheit"] = [](double c) { return (c * 9.0 / 5.0) + 32.0; };
-    conversionFunctions["FahrenheitToCelsius"] = [](double f) { return (f - 32.0) * 5.0 / 9.0; };
-    conversionFunctions["CelsiusToKelvin"] = [](double c) { return c + 273.15; };
-    conversionFunctions["KelvinToCelsius"] = [](double k) { return k - 273.15; };
+    for (const auto& entry : temperatureConversions) registerConversion(entry.name, entry.scale, entry.offset, entry.shift, entry.divisor);
 }
 
 // Registers distance conversions
 void UnitConverter::registerDistanceConversions() {
-    conversionFunctions["KilometersToMiles"] = [](double km) { return km * 0.621371; };
-    conversionFunctions["MilesToKilometers"] = [](double miles) { return miles / 0.621371; };
-    conversionFunctions["MetersToFeet"] = [](double m) { return m * 3.28084; };
-    conversionFunctions["FeetToMeters"] = [](double ft) { return ft / 3.28084; };
+    for (const auto& entry : distanceConversions) registerConversion(entry.name, entry.scale, entry.offset, entry.shift, entry.divisor);
 }
 
 // Registers weight conversions
 void UnitConverter::registerWeightConversions() {
-    conversionFunctions["KilogramsToPounds"] = [](double kg) { return kg * 2.20462; };
-    conversionFunctions["PoundsToKilograms"] = [](double lb) { return lb / 2.20462; };
-    conversionFunctions["GramsToOunces"] = [](double g) { return g * 0.035274; };
-    conversionFunctions["OuncesToGrams"] = [](double oz) { return oz / 0.035274; };
+    for (const auto& entry : weightConversions) registerConversion(entry.name, entry.scale, entry.offset, entry.shift, entry.divisor);
 }
 
 // Registers volume conversions
 void UnitConverter::registerVolumeConversions() {
-    conversionFunctions["LitersToGallons"] = [](double l) { return l * 0.264172; };
-    conversionFunctions["GallonsToLiters"] = [](double gal) { return gal / 0.264172; };
-    conversionFunctions["MillilitersToFluidOunces"] = [](double ml) { return ml * 0.033814; };
-    conversionFunctions["FluidOuncesToMilliliters"] = [](double fl_oz) { return fl_oz / 0.033814; };
+    for (const auto& entry : volumeConversions) registerConversion(entry.name, entry.scale, entry.offset, entry.shift, entry.divisor);
+}
+
+// Registers speed, density and flow rate conversions
+void UnitConverter::registerCompoundConversions() {
+    for (const auto& table : compoundTables) {
+        for (std::size_t i = 0; i < table.size; ++i) {
+            const double scale = compoundScale(table.entries[i]);
+            registerConversion(table.entries[i].name, scale, 0.0, 0.0, 0.0);
+        }
+    }
 }
 
 // Central registration of all conversions
@@ -45,259 +509,964 @@ void UnitConverter::registerConversionFunctions() {
     registerDistanceConversions();
     registerWeightConversions();
     registerVolumeConversions();
+    registerCompoundConversions();
 }
 
 UnitConverter::UnitConverter() {
+    static std::atomic<std::uint64_t> instances{0};
+    instanceId = ++instances;
+    buildUnitPairs();
     registerConversionFunctions();
 }
 
-double UnitConverter::convert(const std::string& conversionType, double value) const {
-    // Validate input ranges for certain categories
-    if (conversionType.find("Celsius") != std::string::npos || conversionType.find("Fahrenheit") != std::string::npos || conversionType.find("Kelvin") != std::string::npos) {
-        // Check not below absolute zero
-        double cVal = (conversionType.find("Fahrenheit") != std::string::npos) ?
-                        ((value - 32.0) * 5.0 / 9.0) :
-                        ((conversionType.find("Kelvin") != std::string::npos) ?
-                            (value - 273.15) : value);
-        if (cVal < -273.15) {
-            throw std::invalid_argument("Temperature value below absolute zero is not valid.");
-        }
+// Derives a validation rule from the words in a conversion name. Conversions
+// between known units validate against the source unit instead, so this only
+// decides which error an unknown name reports first.
+UnitConverter::ValidationRule UnitConverter::validationRuleFor(std::string_view conversionType) {
+    // Temperatures must not be below absolute zero
+    if (conversionType.find("Celsius") != std::string_view::npos || conversionType.find("Fahrenheit") != std::string_view::npos || conversionType.find("Kelvin") != std::string_view::npos) {
+        const char* message = "Temperature value below absolute zero is not valid.";
+        if (conversionType.find("Fahrenheit") != std::string_view::npos) return {-32.0, 5.0, 9.0, -273.15, message};
+        if (conversionType.find("Kelvin") != std::string_view::npos) return {-273.15, 1.0, 1.0, -273.15, message};
+        return {0.0, 1.0, 1.0, -273.15, message};
     }
 
     // Distance should not be negative
-    if (conversionType.find("Kilometers") != std::string::npos || conversionType.find("Miles") != std::string::npos ||
-        conversionType.find("Meters") != std::string::npos || conversionType.find("Feet") != std::string::npos) {
-        if (value < 0) throw std::invalid_argument("Negative distance values are not valid.");
+    if (conversionType.find("Kilometers") != std::string_view::npos || conversionType.find("Miles") != std::string_view::npos ||
+        conversionType.find("Meters") != std::string_view::npos || conversionType.find("Feet") != std::string_view::npos) {
+        return {0.0, 1.0, 1.0, 0.0, "Negative distance values are not valid."};
     }
 
     // Weight should not be negative
-    if (conversionType.find("Kilograms") != std::string::npos || conversionType.find("Pounds") != std::string::npos ||
-        conversionType.find("Grams") != std::string::npos || conversionType.find("Ounces") != std::string::npos) {
-        if (value < 0) throw std::invalid_argument("Negative weight values are not valid.");
+    if (conversionType.find("Kilograms") != std::string_view::npos || conversionType.find("Pounds") != std::string_view::npos ||
+        conversionType.find("Grams") != std::string_view::npos || conversionType.find("Ounces") != std::string_view::npos) {
+        return {0.0, 1.0, 1.0, 0.0, "Negative weight values are not valid."};
     }
 
     // Volume should not be negative
-    if (conversionType.find("Liters") != std::string::npos || conversionType.find("Gallons") != std::string::npos ||
-        conversionType.find("Milliliters") != std::string::npos || conversionType.find("FluidOunces") != std::string::npos) {
-        if (value < 0) throw std::invalid_argument("Negative volume values are not valid.");
+    if (conversionType.find("Liters") != std::string_view::npos || conversionType.find("Gallons") != std::string_view::npos ||
+        conversionType.find("Milliliters") != std::string_view::npos || conversionType.find("FluidOunces") != std::string_view::npos) {
+        return {0.0, 1.0, 1.0, 0.0, "Negative volume values are not valid."};
+    }
+
+    // Anything else accepts every value
+    return {0.0, 1.0, 1.0, -std::numeric_limits<double>::infinity(), ""};
+}
+
+// Bounds applied to inputs under a clamp policy; only Saturate narrows them
+static void clampBounds(ClampPolicy policy, double& low, double& high) {
+    const double limit = (policy == ClampPolicy::Saturate) ? UnitConverter::clampLimit : std::numeric_limits<double>::infinity();
+    low = -limit;
+    high = limit;
+}
+
+static bool beyondClampLimit(double value) {
+    return (value > UnitConverter::clampLimit) | (value < -UnitConverter::clampLimit);
+}
+
+// Validates a value and applies the clamp policy, returning the value to convert
+double UnitConverter::prepareValue(const ValidationRule& rule, double value, ClampPolicy policy, bool* clamped) {
+    if (rule.rejects(value)) {
+        throw std::invalid_argument(rule.message);
     }
 
-    // Clamp excessively large values
-    if (value > 1e6) value = 1e6;
-    else if (value < -1e6) value = -1e6;
+    const bool outOfRange = beyondClampLimit(value);
+    if (clamped) *clamped = outOfRange;
+    if (outOfRange && policy == ClampPolicy::Reject) {
+        throw std::invalid_argument("Value exceeds the supported conversion range.");
+    }
 
-    auto it = conversionFunctions.find(conversionType);
-    if (it != conversionFunctions.end()) {
-        return it->second(value);
+    // Clamp without branching; the bounds are infinite unless saturating
+    double low, high;
+    clampBounds(policy, low, high);
+    return std::min(std::max(value, low), high);
+}
+
+double UnitConverter::convert(std::string_view conversionType, double value, ClampPolicy policy, bool* clamped) const {
+    UnitId from, to;
+    if (splitConversionName(conversionType, from, to) && findPair(from, to)) {
+        return convert(from, to, value, policy, clamped);
     } else {
+        // Out-of-range values are reported before the unknown type
+        prepareValue(validationRuleFor(conversionType), value, policy, clamped);
+        throw std::invalid_argument("Invalid conversion type: " + std::string(conversionType));
+    }
+}
+
+// Slot of a per-thread result cache; only successful conversions are stored
+struct ResultCacheEntry {
+    std::uint64_t bits;
+    ConversionId id;
+    std::uint8_t policy;
+    bool clamped;
+    bool used;
+    double result;
+};
+
+struct ResultCache {
+    std::uint64_t owner;
+    std::vector<ResultCacheEntry> entries;
+    UnitConverter::CacheStatistics statistics;
+};
+
+// Returns the calling thread's cache for converter `owner`, (re)creating it
+// when its size has changed. Keeps caches for the few most recently added
+// converters only.
+static ResultCache& threadResultCache(std::uint64_t owner, std::size_t size) {
+    thread_local std::vector<ResultCache> caches;
+    for (auto& cache : caches) {
+        if (cache.owner == owner) {
+            if (cache.entries.size() != size) {
+                cache.entries.assign(size, ResultCacheEntry{});
+                cache.statistics = {};
+            }
+            return cache;
+        }
+    }
+    if (caches.size() == 8) caches.erase(caches.begin());
+    caches.push_back({owner, std::vector<ResultCacheEntry>(size), {}});
+    return caches.back();
+}
+
+double UnitConverter::convert(ConversionId id, double value, ClampPolicy policy, bool* clamped) const {
+    const Conversion conversion = conversionAt(id);
+    if (resultCacheSize == 0) {
+        return applyConversion(conversion, prepareValue(conversion.rule, value, policy, clamped));
+    }
+
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    ResultCache& cache = threadResultCache(instanceId, resultCacheSize);
+    // Mix all key bits into the low ones (MurmurHash3 finalizer)
+    std::uint64_t hash = bits ^ (std::uint64_t(id) << 8) ^ std::uint64_t(policy);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    ResultCacheEntry& entry = cache.entries[hash & (resultCacheSize - 1)];
+
+    if (entry.used && entry.bits == bits && entry.id == id && entry.policy == static_cast<std::uint8_t>(policy)) {
+        ++cache.statistics.hits;
+        if (clamped) *clamped = entry.clamped;
+        return entry.result;
+    }
+
+    ++cache.statistics.misses;
+    bool wasClamped;
+    const double result = applyConversion(conversion, prepareValue(conversion.rule, value, policy, &wasClamped));
+    entry = {bits, id, static_cast<std::uint8_t>(policy), wasClamped, true, result};
+    if (clamped) *clamped = wasClamped;
+    return result;
+}
+
+void UnitConverter::setResultCacheSize(std::size_t entries) {
+    std::size_t size = entries == 0 ? 0 : 1;
+    while (size != 0 && size < entries) size <<= 1;
+    resultCacheSize = size;
+}
+
+UnitConverter::CacheStatistics UnitConverter::resultCacheStatistics() const {
+    if (resultCacheSize == 0) return {};
+    return threadResultCache(instanceId, resultCacheSize).statistics;
+}
+
+std::size_t UnitConverter::convertBatch(const std::string& conversionType, const double* input, double* output,
+                                        std::size_t count, ClampPolicy policy) const {
+    UnitId from, to;
+    if (!splitConversionName(conversionType, from, to) || !findPair(from, to)) {
         throw std::invalid_argument("Invalid conversion type: " + conversionType);
     }
+    return convertBatch(from, to, input, output, count, policy);
 }
 
-// Helper function to safely read a double value
-bool safeReadDouble(double &val) {
-    std::cin >> val;
-    if(std::cin.fail()) {
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        return false;
+std::size_t UnitConverter::convertBatch(ConversionId id, const double* input, double* output,
+                                        std::size_t count, ClampPolicy policy) const {
+    return convertBatch(conversionAt(id), input, output, count, policy);
+}
+
+double UnitConverter::convert(UnitId from, UnitId to, double value, ClampPolicy policy, bool* clamped) const {
+    const UnitPair* pair = findPair(from, to);
+    if (!pair) {
+        throw std::invalid_argument(std::string("Cannot convert ") + units[from].info.name + " to " +
+                                    units[to].info.name + ".");
     }
-    return true;
+    return convert(pairConversionId(*pair), value, policy, clamped);
 }
 
-// Conversion Functions for user interaction
-void convertTemperature(const UnitConverter& converter) {
-    double value;
-    std::string type;
+std::size_t UnitConverter::convertBatch(UnitId from, UnitId to, const double* input, double* output,
+                                        std::size_t count, ClampPolicy policy) const {
+    const UnitPair* pair = findPair(from, to);
+    if (!pair) {
+        throw std::invalid_argument(std::string("Cannot convert ") + units[from].info.name + " to " +
+                                    units[to].info.name + ".");
+    }
+    return convertBatch(conversionAt(pairConversionId(*pair)), input, output, count, policy);
+}
+
+std::size_t UnitConverter::convertBatch(const Conversion& conversion, const double* input, double* output,
+                                        std::size_t count, ClampPolicy policy) const {
+    const std::size_t outOfRange = prepareBatch(conversion.rule, input, output, count, policy);
+    applyConversion(conversion, output, count);
+    return outOfRange;
+}
 
-    std::cout << "Enter temperature value: ";
-    if(!safeReadDouble(value)) {
-        std::cerr << "Invalid input. Please enter a numeric value.\n";
+double UnitConverter::applyConversion(const Conversion& conversion, double value) {
+    return conversion.divisor != 0.0 ? (value + conversion.shift) / conversion.divisor
+                                     : value * conversion.scale + conversion.offset;
+}
+
+// Inline, one loop per form, so the loops vectorize
+void UnitConverter::applyConversion(const Conversion& conversion, double* values, std::size_t count) {
+    const double divisor = conversion.divisor;
+    if (divisor != 0.0) {
+        const double shift = conversion.shift;
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] = (values[i] + shift) / divisor;
+        }
         return;
     }
-    std::cout << "Choose conversion type:\n";
-    std::cout << "1. CelsiusToFahrenheit\n";
-    std::cout << "2. FahrenheitToCelsius\n";
-    std::cout << "3. CelsiusToKelvin\n";
-    std::cout << "4. KelvinToCelsius\n";
-    std::cout << "Enter choice: ";
-    int choice;
-    std::cin >> choice;
-
-    switch(choice) {
-        case 1: type = "CelsiusToFahrenheit"; break;
-        case 2: type = "FahrenheitToCelsius"; break;
-        case 3: type = "CelsiusToKelvin"; break;
-        case 4: type = "KelvinToCelsius"; break;
-        default: 
-            std::cerr << "Invalid conversion selection.\n";
-            return;
+    const double scale = conversion.scale;
+    const double offset = conversion.offset;
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = values[i] * scale + offset;
     }
+}
 
-    try {
-        double result = converter.convert(type, value);
-        std::cout << "Converted value: " << std::fixed << std::setprecision(2) << result << "\n";
-    } catch (const std::invalid_argument& e) {
-        std::cerr << "Error: " << e.what() << "\n";
+// Validates, counts and clamps a batch into `output`, throwing like prepareValue()
+std::size_t UnitConverter::prepareBatch(const ValidationRule& rule, const double* input, double* output,
+                                        std::size_t count, ClampPolicy policy) {
+    double low, high;
+    clampBounds(policy, low, high);
+
+    // Validate, count and clamp in one branch-free pass so the loop vectorizes
+    bool invalid = false;
+    std::size_t outOfRange = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double value = input[i];
+        invalid |= rule.rejects(value);
+        outOfRange += beyondClampLimit(value);
+        output[i] = std::min(std::max(value, low), high);
+    }
+
+    if (invalid) {
+        throw std::invalid_argument(rule.message);
     }
+    if (outOfRange != 0 && policy == ClampPolicy::Reject) {
+        throw std::invalid_argument("Value exceeds the supported conversion range.");
+    }
+    return outOfRange;
 }
 
-void convertDistance(const UnitConverter& converter) {
-    double value;
-    std::string type;
+Measurement UnitConverter::convert(ConversionId id, const Measurement& measurement, ClampPolicy policy) const {
+    Measurement result;
+    convertBatch(id, &measurement, &result, 1, policy);
+    return result;
+}
 
-    std::cout << "Enter distance value: ";
-    if(!safeReadDouble(value)) {
-        std::cerr << "Invalid input. Please enter a numeric value.\n";
-        return;
+std::size_t UnitConverter::convertBatch(ConversionId id, const Measurement* input, Measurement* output,
+                                        std::size_t count, ClampPolicy policy) const {
+    const Conversion conversion = conversionAt(id);
+    const double spread = std::fabs(conversion.scale);
+    const bool reverses = conversion.scale < 0.0;
+    double low, high;
+    clampBounds(policy, low, high);
+
+    // Values go through the regular batch path in chunks. The bounds are
+    // clamped the same way and converted by the same inline arithmetic, which
+    // is monotonic, so the converted value stays within its converted bounds.
+    std::size_t outOfRange = 0;
+    double values[1024];
+    double lows[1024];
+    double highs[1024];
+    for (std::size_t start = 0; start < count; start += 1024) {
+        const std::size_t n = std::min<std::size_t>(1024, count - start);
+        const Measurement* in = input + start;
+        Measurement* out = output + start;
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = in[i].value;
+            lows[i] = std::min(std::max(in[i].low, low), high);
+            highs[i] = std::min(std::max(in[i].high, low), high);
+        }
+        outOfRange += convertBatch(conversion, values, values, n, policy);
+        applyConversion(conversion, lows, n);
+        applyConversion(conversion, highs, n);
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const double a = lows[i];
+            const double b = highs[i];
+            out[i].value = values[i];
+            out[i].uncertainty = in[i].uncertainty * spread;
+            out[i].low = reverses ? b : a;
+            out[i].high = reverses ? a : b;
+        }
     }
-    std::cout << "Choose conversion type:\n";
-    std::cout << "1. KilometersToMiles\n";
-    std::cout << "2. MilesToKilometers\n";
-    std::cout << "3. MetersToFeet\n";
-    std::cout << "4. FeetToMeters\n";
-    std::cout << "Enter choice: ";
-    int choice;
-    std::cin >> choice;
-
-    switch(choice) {
-        case 1: type = "KilometersToMiles"; break;
-        case 2: type = "MilesToKilometers"; break;
-        case 3: type = "MetersToFeet"; break;
-        case 4: type = "FeetToMeters"; break;
-        default: 
-            std::cerr << "Invalid conversion selection.\n";
-            return;
+    return outOfRange;
+}
+
+std::size_t UnitConverter::convertBatchChecked(ConversionId id, const double* input, double* output, std::uint8_t* valid,
+                                               std::size_t count, ClampPolicy policy) const {
+    const Conversion conversion = conversionAt(id);
+    const ValidationRule& rule = conversion.rule;
+    const bool rejectOutOfRange = policy == ClampPolicy::Reject;
+    double low, high;
+    clampBounds(policy, low, high);
+
+    std::size_t outOfRange = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double value = input[i];
+        const bool beyond = beyondClampLimit(value);
+        valid[i] = !rule.rejects(value) & !(rejectOutOfRange & beyond);
+        outOfRange += beyond;
+        output[i] = std::min(std::max(value, low), high);
     }
 
-    try {
-        double result = converter.convert(type, value);
-        std::cout << "Converted value: " << std::fixed << std::setprecision(2) << result << "\n";
-    } catch (const std::invalid_argument& e) {
-        std::cerr << "Error: " << e.what() << "\n";
+    // Convert every slot, then mask the invalid ones in a separate pass, so
+    // both loops stay branch-free
+    applyConversion(conversion, output, count);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (std::size_t i = 0; i < count; ++i) {
+        output[i] = valid[i] ? output[i] : nan;
     }
+    return outOfRange;
 }
 
-void convertWeight(const UnitConverter& converter) {
-    double value;
-    std::string type;
+double UnitConverter::convertChecked(ConversionId id, double value, ClampPolicy policy) const noexcept {
+    if (!accepts(id, value, policy)) return std::numeric_limits<double>::quiet_NaN();
+    double low, high;
+    clampBounds(policy, low, high);
+    return applyConversion(conversionAt(id), std::min(std::max(value, low), high));
+}
 
-    std::cout << "Enter weight value: ";
-    if(!safeReadDouble(value)) {
-        std::cerr << "Invalid input. Please enter a numeric value.\n";
-        return;
+bool UnitConverter::accepts(ConversionId id, double value, ClampPolicy policy) const noexcept {
+    return !conversionAt(id).rule.rejects(value) & !(policy == ClampPolicy::Reject && beyondClampLimit(value));
+}
+
+// Reduction of part of a batch in the source unit. Four lanes are kept so the
+// loop vectorizes without reassociating floating-point additions.
+struct PartialSummary {
+    static constexpr std::size_t lanes = 4;
+    double sum[lanes] = {};
+    double compensation[lanes] = {};
+    double min[lanes];
+    double max[lanes];
+    std::size_t outOfRange = 0;
+    bool invalid = false;
+
+    PartialSummary() {
+        std::fill(min, min + lanes, std::numeric_limits<double>::infinity());
+        std::fill(max, max + lanes, -std::numeric_limits<double>::infinity());
     }
-    std::cout << "Choose conversion type:\n";
-    std::cout << "1. KilogramsToPounds\n";
-    std::cout << "2. PoundsToKilograms\n";
-    std::cout << "3. GramsToOunces\n";
-    std::cout << "4. OuncesToGrams\n";
-    std::cout << "Enter choice: ";
-    int choice;
-    std::cin >> choice;
-
-    switch(choice) {
-        case 1: type = "KilogramsToPounds"; break;
-        case 2: type = "PoundsToKilograms"; break;
-        case 3: type = "GramsToOunces"; break;
-        case 4: type = "OuncesToGrams"; break;
-        default:
-            std::cerr << "Invalid conversion selection.\n";
-            return;
+
+    template <bool compensated>
+    void accumulate(std::size_t lane, double value) {
+        if (compensated) {
+            // Neumaier: keep the low-order bits lost by each addition
+            const double total = sum[lane] + value;
+            compensation[lane] += std::fabs(sum[lane]) >= std::fabs(value) ? (sum[lane] - total) + value
+                                                                           : (value - total) + sum[lane];
+            sum[lane] = total;
+        } else {
+            sum[lane] += value;
+        }
     }
 
-    try {
-        double result = converter.convert(type, value);
-        std::cout << "Converted value: " << std::fixed << std::setprecision(2) << result << "\n";
-    } catch (const std::invalid_argument& e) {
-        std::cerr << "Error: " << e.what() << "\n";
+    template <bool compensated>
+    void add(std::size_t lane, double value) {
+        accumulate<compensated>(lane, value);
+        min[lane] = std::min(min[lane], value);
+        max[lane] = std::max(max[lane], value);
+    }
+
+    template <bool compensated, typename Rule>
+    void reduce(const Rule& rule, const double* input, std::size_t count, double low, double high) {
+        std::size_t i = 0;
+        for (; i + lanes <= count; i += lanes) {
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                const double value = input[i + lane];
+                invalid |= rule.rejects(value);
+                outOfRange += beyondClampLimit(value);
+                add<compensated>(lane, std::min(std::max(value, low), high));
+            }
+        }
+        for (; i < count; ++i) {
+            invalid |= rule.rejects(input[i]);
+            outOfRange += beyondClampLimit(input[i]);
+            add<compensated>(0, std::min(std::max(input[i], low), high));
+        }
     }
+};
+
+ConversionSummary UnitConverter::summarize(ConversionId id, const double* input, std::size_t count,
+                                           ClampPolicy policy, Summation summation, unsigned threads) const {
+    return summarize(conversionAt(id), input, count, policy, summation, threads);
 }
 
-// Convert Volume category
-void convertVolume(const UnitConverter& converter) {
-    double value;
-    std::string type;
+ConversionSummary UnitConverter::summarize(const std::string& conversionType, const double* input, std::size_t count,
+                                           ClampPolicy policy, Summation summation, unsigned threads) const {
+    UnitId from, to;
+    if (!splitConversionName(conversionType, from, to) || !findPair(from, to)) {
+        throw std::invalid_argument("Invalid conversion type: " + conversionType);
+    }
+    return summarize(pairConversionId(*findPair(from, to)), input, count, policy, summation, threads);
+}
+
+ConversionSummary UnitConverter::summarize(const Conversion& conversion, const double* input, std::size_t count,
+                                           ClampPolicy policy, Summation summation, unsigned threads) const {
+    const ValidationRule& rule = conversion.rule;
+    const double scale = conversion.scale;
+    const double offset = conversion.offset;
+    double low, high;
+    clampBounds(policy, low, high);
+
+    // Each thread reduces one contiguous slice; small batches stay on this one
+    constexpr std::size_t minimumSlice = 1 << 16;
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, count / minimumSlice)));
+    std::vector<PartialSummary> partials(threads);
+    auto reduceSlice = [&](unsigned slice) {
+        const std::size_t start = count * slice / threads;
+        const std::size_t end = count * (slice + 1) / threads;
+        if (summation == Summation::Compensated) {
+            partials[slice].reduce<true>(rule, input + start, end - start, low, high);
+        } else {
+            partials[slice].reduce<false>(rule, input + start, end - start, low, high);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned slice = 1; slice < threads; ++slice) workers.emplace_back(reduceSlice, slice);
+    reduceSlice(0);
+    for (auto& worker : workers) worker.join();
+
+    // Combine lanes and slices, compensated or not, in the source unit
+    PartialSummary total;
+    for (const PartialSummary& partial : partials) {
+        total.invalid |= partial.invalid;
+        total.outOfRange += partial.outOfRange;
+        for (std::size_t lane = 0; lane < PartialSummary::lanes; ++lane) {
+            if (summation == Summation::Compensated) {
+                total.accumulate<true>(0, partial.sum[lane]);
+                total.accumulate<true>(0, partial.compensation[lane]);
+            } else {
+                total.accumulate<false>(0, partial.sum[lane]);
+            }
+            total.min[0] = std::min(total.min[0], partial.min[lane]);
+            total.max[0] = std::max(total.max[0], partial.max[lane]);
+        }
+    }
+    if (total.invalid) {
+        throw std::invalid_argument(rule.message);
+    }
+    if (total.outOfRange != 0 && policy == ClampPolicy::Reject) {
+        throw std::invalid_argument("Value exceeds the supported conversion range.");
+    }
+
+    // Convert the reductions once. Registered conversions convert the mean
+    // and extremes exactly as they would each value.
+    ConversionSummary summary;
+    summary.count = count;
+    summary.outOfRange = total.outOfRange;
+    const double sum = total.sum[0] + total.compensation[0];
+    summary.sum = sum * scale + offset * static_cast<double>(count);
+    if (count == 0) {
+        summary.mean = summary.min = summary.max = std::numeric_limits<double>::quiet_NaN();
+        return summary;
+    }
+    auto convertOne = [&](double value) { return applyConversion(conversion, value); };
+    summary.mean = convertOne(sum / static_cast<double>(count));
+    summary.min = convertOne(scale < 0.0 ? total.max[0] : total.min[0]);
+    summary.max = convertOne(scale < 0.0 ? total.min[0] : total.max[0]);
+    return summary;
+}
+
+std::size_t SourceRange::select(const double* values, std::size_t count, std::size_t* indices) const {
+    // Always store, advance only on a match, so the loop has no branches
+    std::size_t selected = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        indices[selected] = i;
+        selected += matches(values[i]);
+    }
+    return selected;
+}
+
+// Maps doubles other than NaN to integers in the same order, so that a
+// search over doubles can bisect their bit patterns
+static std::uint64_t orderedBits(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const std::uint64_t sign = std::uint64_t(1) << 63;
+    return (bits & sign) ? ~bits : bits | sign;
+}
+
+static double fromOrderedBits(std::uint64_t key) {
+    const std::uint64_t sign = std::uint64_t(1) << 63;
+    const std::uint64_t bits = (key & sign) ? key ^ sign : ~key;
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Smallest x for which the nondecreasing `function` reaches `constant`
+// (exceeds it if `strict`). The boundary is bracketed from the estimate
+// `guess` with steps that double, then bisected, so the search takes at most
+// about 128 evaluations however many doubles lie between guess and answer
+// (e.g. all the tiny values that 32 + x * 1.8 rounds to 32).
+template <typename Function>
+static double firstReaching(const Function& function, double guess, double constant, bool strict) {
+    auto reached = [&](std::uint64_t key) {
+        const double y = function(fromOrderedBits(key));
+        return strict ? y > constant : y >= constant;
+    };
+    const double infinity = std::numeric_limits<double>::infinity();
+    const std::uint64_t lowest = orderedBits(-infinity);
+    const std::uint64_t highest = orderedBits(infinity);
+
+    // Find low < high with !reached(low) and reached(high)
+    std::uint64_t low, high;
+    const std::uint64_t start = orderedBits(guess);
+    if (reached(start)) {
+        high = start;
+        for (std::uint64_t step = 1;; step *= 2) {
+            if (high - lowest <= step) {
+                if (reached(lowest)) return -infinity;
+                low = lowest;
+                break;
+            }
+            low = high - step;
+            if (!reached(low)) break;
+            high = low;
+        }
+    } else {
+        low = start;
+        for (std::uint64_t step = 1;; step *= 2) {
+            if (highest - low <= step) {
+                if (!reached(highest)) return infinity;
+                high = highest;
+                break;
+            }
+            high = low + step;
+            if (reached(high)) break;
+            low = high;
+        }
+    }
+
+    while (high - low > 1) {
+        const std::uint64_t middle = low + (high - low) / 2;
+        (reached(middle) ? high : low) = middle;
+    }
+    return fromOrderedBits(high);
+}
+
+template <typename Function>
+SourceRange UnitConverter::pushDown(const Function& function, double scale, Comparison comparison, double constant) {
+    if (!std::isfinite(constant)) {
+        throw std::invalid_argument("Predicate constant must be finite.");
+    }
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // A decreasing conversion is searched as the increasing y -> f(-y), and
+    // the range is mirrored back at the end
+    const bool decreasing = scale < 0.0;
+    auto increasing = [&](double y) { return decreasing ? function(-y) : function(y); };
+    const double guess = (constant - function(0.0)) / scale * (decreasing ? -1.0 : 1.0);
+    const double above = firstReaching(increasing, guess, constant, true);   // first y with f > constant
+    const double atLeast = firstReaching(increasing, guess, constant, false); // first y with f >= constant
+
+    SourceRange range{-infinity, infinity, false};
+    switch (comparison) {
+    case Comparison::Greater:      range.low = above; break;
+    case Comparison::GreaterEqual: range.low = atLeast; break;
+    case Comparison::Less:         range.high = std::nextafter(atLeast, -infinity); break;
+    case Comparison::LessEqual:    range.high = std::nextafter(above, -infinity); break;
+    case Comparison::Equal:
+    case Comparison::NotEqual:
+        range = {atLeast, std::nextafter(above, -infinity), comparison == Comparison::NotEqual};
+        break;
+    }
+    if (decreasing) range = {-range.high, -range.low, range.negated};
+    return range;
+}
+
+SourceRange UnitConverter::pushDown(ConversionId id, Comparison comparison, double constant) const {
+    const Conversion conversion = conversionAt(id);
+    return pushDown([&conversion](double x) { return applyConversion(conversion, x); }, conversion.scale, comparison,
+                    constant);
+}
+
+SourceRange UnitConverter::pushDown(const std::string& conversionType, Comparison comparison, double constant) const {
+    const UnitPair* pair = findPair(conversionType);
+    if (!pair) {
+        throw std::invalid_argument("Invalid conversion type: " + conversionType);
+    }
+    return pushDown(pairConversionId(*pair), comparison, constant);
+}
+
+ConversionId UnitConverter::conversionId(const std::string& conversionType) const {
+    const UnitPair* pair = findPair(conversionType);
+    if (!pair) {
+        throw std::invalid_argument("Invalid conversion type: " + conversionType);
+    }
+    return pairConversionId(*pair);
+}
+
+ConversionId UnitConverter::conversionId(UnitId from, UnitId to) const {
+    const UnitPair* pair = findPair(from, to);
+    if (!pair) {
+        throw std::invalid_argument(std::string("Cannot convert ") + unitInfo(from).name + " to " +
+                                    unitInfo(to).name + ".");
+    }
+    return pairConversionId(*pair);
+}
+
+UnitConverter::AffineMap UnitConverter::affineMap(ConversionId id) const {
+    const Conversion conversion = conversionAt(id);
+    return {conversion.scale, conversion.offset};
+}
+
+UnitConverter::ElementConversion UnitConverter::elementConversion(ConversionId id, ClampPolicy policy) const {
+    const Conversion conversion = conversionAt(id);
+    double low, high;
+    clampBounds(policy, low, high);
+    return {conversion.rule, low, high, policy == ClampPolicy::Reject,
+            conversion.scale, conversion.offset, conversion.shift, conversion.divisor};
+}
+
+ConversionId UnitConverter::pairConversionId(const UnitPair& pair) const {
+    if (pair.conversion != noConversion) return pair.conversion;
+    return static_cast<ConversionId>(conversions.size() + static_cast<std::size_t>(&pair - pairs.data()));
+}
+
+UnitConverter::Conversion UnitConverter::conversionAt(ConversionId id) const {
+    if (id < conversions.size()) return conversions[id];
+    const UnitPair& pair = pairs.at(id - conversions.size());
+    if (pair.conversion != noConversion) return conversions[pair.conversion];
+    return {unitRules[pair.from], pair.scale, pair.offset, 0.0, 0.0, pair.from, pair.to};
+}
+
+std::string UnitConverter::conversionName(ConversionId id) const {
+    const Conversion conversion = conversionAt(id);
+    return std::string(units[conversion.from].info.name) + "To" + units[conversion.to].info.name;
+}
+
+// Console setup for the interactive tool: iostreams no longer sync with
+// stdio, std::cin no longer flushes std::cout before every read and prompts
+// collect in a large buffer. Must run before any console I/O.
+void setupConsole() {
+    static char outputBuffer[1 << 16];
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+}
+
+// Streams and presentation of one run of the menu protocol. Interactively,
+// prompts and results go to `out` and errors to std::cerr. In replay mode
+// no prompts are shown and every outcome becomes one tab-separated record on
+// `out`: "ok <conversion> <value> <result>", "error <message>" or "exit".
+struct MenuSession {
+    std::istream& in;
+    std::ostream& out;
+    bool replay;
+    std::size_t errors = 0;
+
+    // Flushes pending prompts only if the read is about to block. Input that
+    // is already buffered (e.g. piped in) is read without any flush, so a
+    // scripted session writes its output in large chunks.
+    template <typename T>
+    std::istream& read(T& value) {
+        if (!replay && in.rdbuf()->in_avail() <= 0) out.flush();
+        return in >> value;
+    }
+
+    // Reads a double, skipping the rest of the line if it is not one
+    bool readDouble(double& value) {
+        read(value);
+        if (in.fail()) {
+            in.clear();
+            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return false;
+        }
+        return true;
+    }
+
+    std::ostream& prompt() {
+        static std::ostream discard(nullptr);
+        return replay ? discard : out;
+    }
 
-    std::cout << "Enter volume value: ";
-    if(!safeReadDouble(value)) {
-        std::cerr << "Invalid input. Please enter a numeric value.\n";
+    void error(const std::string& message) {
+        ++errors;
+        if (replay) {
+            out << "error\t" << message << "\n";
+        } else {
+            std::cerr << message << "\n";
+        }
+    }
+
+    void result(const char* conversion, double value, double converted) {
+        if (replay) {
+            out << "ok\t" << conversion << "\t" << std::setprecision(17) << value << "\t" << converted << "\n";
+        } else {
+            out << "Converted value: " << std::fixed << std::setprecision(2) << converted << "\n";
+        }
+    }
+};
+
+// Helper function to safely read a double value
+bool safeReadDouble(double &val) {
+    MenuSession session{std::cin, std::cout, false};
+    return session.readDouble(val);
+}
+
+// One menu engine serves every category, listing the conversions registered
+// for it
+static void runCategory(const UnitConverter& converter, Category category, MenuSession& session) {
+    const std::vector<ConversionInfo> options = listConversions(category);
+    std::string noun;
+    for (const CategoryInfo& info : listCategories()) {
+        if (info.category == category) noun = info.name;
+    }
+    std::transform(noun.begin(), noun.end(), noun.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    double value;
+    session.prompt() << "Enter " << noun << " value: ";
+    if(!session.readDouble(value)) {
+        session.error("Invalid input. Please enter a numeric value.");
         return;
     }
-    std::cout << "Choose conversion type:\n";
-    std::cout << "1. LitersToGallons\n";
-    std::cout << "2. GallonsToLiters\n";
-    std::cout << "3. MillilitersToFluidOunces\n";
-    std::cout << "4. FluidOuncesToMilliliters\n";
-    std::cout << "Enter choice: ";
-    int choice;
-    std::cin >> choice;
-
-    switch(choice) {
-        case 1: type = "LitersToGallons"; break;
-        case 2: type = "GallonsToLiters"; break;
-        case 3: type = "MillilitersToFluidOunces"; break;
-        case 4: type = "FluidOuncesToMilliliters"; break;
-        default:
-            std::cerr << "Invalid conversion selection.\n";
-            return;
+    std::ostream& prompt = session.prompt();
+    prompt << "Choose conversion type:\n";
+    for (std::size_t i = 0; i < options.size(); ++i) {
+        prompt << i + 1 << ". " << options[i].name << "\n";
+    }
+    prompt << "Enter choice: ";
+    int choice = 0;
+    session.read(choice);
+
+    if (session.in.fail() || choice < 1 || choice > static_cast<int>(options.size())) {
+        session.in.clear();
+        session.error("Invalid conversion selection.");
+        return;
     }
 
     try {
-        double result = converter.convert(type, value);
-        std::cout << "Converted value: " << std::fixed << std::setprecision(2) << result << "\n";
+        session.result(options[choice - 1].name, value, converter.convert(options[choice - 1].name, value));
     } catch (const std::invalid_argument& e) {
-        std::cerr << "Error: " << e.what() << "\n";
+        session.error(std::string("Error: ") + e.what());
+    }
+}
+
+// Main menu numbers. They predate the compound categories and recorded
+// sessions rely on them, so the first categories keep 1-4 and Exit keeps 5;
+// the categories added since are reached through 6.
+static constexpr std::size_t mainMenuCategories = 4;
+static constexpr int exitChoice = 5;
+static constexpr int moreChoice = 6;
+
+// Lets the user pick one of the categories beyond the main menu's
+static void runMoreCategories(const UnitConverter& converter, const std::vector<CategoryInfo>& categories,
+                              MenuSession& session) {
+    std::ostream& prompt = session.prompt();
+    prompt << "Choose a category:\n";
+    for (std::size_t i = mainMenuCategories; i < categories.size(); ++i) {
+        prompt << i - mainMenuCategories + 1 << ". Convert " << categories[i].name << "\n";
     }
+    prompt << "Enter choice: ";
+    int choice = 0;
+    session.read(choice);
+
+    if (session.in.fail() || choice < 1 || choice > static_cast<int>(categories.size() - mainMenuCategories)) {
+        session.in.clear();
+        session.error("Invalid category selection.");
+        return;
+    }
+    runCategory(converter, categories[mainMenuCategories + choice - 1].category, session);
+}
+
+// Runs the main menu until the user exits (returns true) or input ends
+static bool runMenu(const UnitConverter& converter, MenuSession& session) {
+    const std::vector<CategoryInfo> categories = listCategories();
+
+    for (;;) {
+        if (!session.replay) displayMenu();
+        int choice = 0;
+        session.read(choice);
+
+        if(session.in.fail()) {
+            if (session.in.eof()) return false;
+            session.in.clear();
+            session.in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            session.error("Invalid input. Please enter a number corresponding to the menu option.");
+            continue;
+        }
+
+        if (choice >= 1 && choice <= static_cast<int>(mainMenuCategories)) {
+            runCategory(converter, categories[choice - 1].category, session);
+        } else if (choice == exitChoice) {
+            session.out << (session.replay ? "exit\n" : "Exiting...\n");
+            return true;
+        } else if (choice == moreChoice && categories.size() > mainMenuCategories) {
+            runMoreCategories(converter, categories, session);
+        } else {
+            session.error("Invalid option. Please try again.");
+        }
+    }
+}
+
+// Conversion Functions for user interaction
+void convertCategory(const UnitConverter& converter, Category category) {
+    MenuSession session{std::cin, std::cout, false};
+    runCategory(converter, category, session);
+}
+
+void convertTemperature(const UnitConverter& converter) {
+    convertCategory(converter, Category::Temperature);
+}
+
+void convertDistance(const UnitConverter& converter) {
+    convertCategory(converter, Category::Distance);
 }
 
+void convertWeight(const UnitConverter& converter) {
+    convertCategory(converter, Category::Weight);
+}
+
+// Convert Volume category
+void convertVolume(const UnitConverter& converter) {
+    convertCategory(converter, Category::Volume);
+}
+
+// Lists the main categories, Exit, and the entry for the other categories
 void displayMenu() {
+    const std::vector<CategoryInfo> categories = listCategories();
     std::cout << "\nUnit Converter\n";
-    std::cout << "1. Convert Temperature\n";
-    std::cout << "2. Convert Distance\n";
-    std::cout << "3. Convert Weight\n";
-    std::cout << "4. Convert Volume\n";
-    std::cout << "5. Exit\n";
+    for (std::size_t i = 0; i < mainMenuCategories; ++i) {
+        std::cout << i + 1 << ". Convert " << categories[i].name << "\n";
+    }
+    std::cout << exitChoice << ". Exit\n";
+    if (categories.size() > mainMenuCategories) {
+        std::cout << moreChoice << ". Other categories (";
+        for (std::size_t i = mainMenuCategories; i < categories.size(); ++i) {
+            std::cout << (i > mainMenuCategories ? ", " : "") << categories[i].name;
+        }
+        std::cout << ")\n";
+    }
     std::cout << "Choose an option: ";
 }
 
-#ifndef UNIT_TEST
-int main() {
-    UnitConverter converter;
-    int choice;
+void runInteractive(const UnitConverter& converter) {
+    MenuSession session{std::cin, std::cout, false};
+    runMenu(converter, session);
+}
 
-    do {
-        displayMenu();
-        std::cin >> choice;
+std::size_t replaySessions(const UnitConverter& converter, std::istream& script, std::ostream& out) {
+    MenuSession session{script, out, true};
+    while (runMenu(converter, session)) {
+    }
+    return session.errors;
+}
 
-        if(std::cin.fail()) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cerr << "Invalid input. Please enter a number corresponding to the menu option.\n";
-            continue;
+// One-shot mode: `unit_converter <ConversionType> <value>...` prints one result
+// per line, or nan for each value that cannot be converted (with the reason on
+// stderr), and returns non-zero if any value failed. It only uses stdio and a
+// converter, whose tables are plain data, so no menus or iostream state are
+// set up.
+int runConversionCommand(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <ConversionType> <value>...\n", argc > 0 ? argv[0] : "unit_converter");
+        return 2;
+    }
+
+    const UnitConverter converter;
+    ConversionId id;
+    try {
+        id = converter.conversionId(argv[1]);
+    } catch (const std::invalid_argument& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 2; i < argc; ++i) {
+        char* end;
+        const double value = std::strtod(argv[i], &end);
+        double result = std::numeric_limits<double>::quiet_NaN();
+        if (end == argv[i] || *end != '\0') {
+            std::fprintf(stderr, "Error: Invalid numeric value: %s\n", argv[i]);
+            status = 1;
+        } else {
+            try {
+                result = converter.convert(id, value);
+            } catch (const std::invalid_argument& e) {
+                std::fprintf(stderr, "Error: %s\n", e.what());
+                status = 1;
+            }
         }
+        std::printf("%.15g\n", result);
+    }
+    return status;
+}
 
-        switch (choice) {
-        case 1:
-            convertTemperature(converter);
-            break;
-        case 2:
-            convertDistance(converter);
-            break;
-        case 3:
-            convertWeight(converter);
-            break;
-        case 4:
-            convertVolume(converter);
-            break;
-        case 5:
-            std::cout << "Exiting...\n";
+#ifndef UNIT_TEST
+// Parses the --serve-ring capacity: a power of two from 1 to 2^30
+static bool parseRingCapacity(const char* text, std::uint32_t& capacity) {
+    char* end;
+    errno = 0;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || text[0] == '-') return false;
+    if (value == 0 || value > (1ull << 30) || (value & (value - 1)) != 0) return false;
+    capacity = static_cast<std::uint32_t>(value);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::strcmp(argv[1], "--serve") == 0) {
+        try {
+            UnitConverter converter;
+            ConversionServer server(converter, argv[2]);
+            server.run();
+            return 0;
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "Error: %s\n", e.what());
+            return 1;
+        }
+    }
+    if ((argc == 3 || argc == 4) && std::strcmp(argv[1], "--serve-ring") == 0) {
+        std::uint32_t capacity = 1u << 16;
+        if (argc == 4 && !parseRingCapacity(argv[3], capacity)) {
+            std::fprintf(stderr, "Error: Invalid ring capacity: %s (a power of two from 1 to 2^30)\n", argv[3]);
+            std::fprintf(stderr, "Usage: %s --serve-ring <name> [capacity]\n", argv[0]);
+            return 2;
+        }
+        try {
+            UnitConverter converter;
+            ConversionRing ring = ConversionRing::create(argv[2], capacity);
+            ring.serve(converter);
             return 0;
-        default:
-            std::cerr << "Invalid option. Please try again.\n";
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "Error: %s\n", e.what());
+            return 1;
         }
-    } while (choice != 5);
+    }
+    if ((argc == 2 || argc == 3) && std::strcmp(argv[1], "--replay") == 0) {
+        setupConsole();
+        UnitConverter converter;
+        if (argc == 2) return replaySessions(converter, std::cin, std::cout) == 0 ? 0 : 1;
+        std::ifstream script(argv[2]);
+        if (!script) {
+            std::fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+            return 2;
+        }
+        return replaySessions(converter, script, std::cout) == 0 ? 0 : 1;
+    }
+    if (argc > 1) {
+        // Results go out in one write at exit instead of one per line
+        static char outputBuffer[1 << 16];
+        std::setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+        return runConversionCommand(argc, argv);
+    }
 
+    setupConsole();
+    UnitConverter converter;
+    runInteractive(converter);
     return 0;
 }
 #endif
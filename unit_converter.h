@@ -2,32 +2,364 @@
 #define UNIT_CONVERTER_H
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <algorithm>
 #include <functional>
+#include <stdexcept>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// How convert() treats input values beyond +/- UnitConverter::clampLimit
+enum class ClampPolicy {
+    Saturate,    // clamp to the limit before converting (default)
+    Reject,      // throw std::invalid_argument
+    PassThrough  // convert the value unchanged
+};
+
+// Physical dimension a unit measures
+enum class Dimension { Temperature, Length, Mass, Volume, Speed, Density, FlowRate };
+
+// Groups of conversions as offered to users
+enum class Category { Temperature, Distance, Weight, Volume, Speed, Density, FlowRate };
+
+struct UnitInfo {
+    const char* name;   // e.g. "Kilometers", as used in conversion names
+    const char* symbol; // e.g. "km"
+    Dimension dimension;
+};
+
+struct ConversionInfo {
+    const char* name;   // e.g. "KilometersToMiles"
+    const char* from;
+    const char* to;
+    Category category;
+};
+
+struct CategoryInfo {
+    Category category;
+    const char* name;
+    Dimension dimension;
+};
+
+// Queries over the built-in tables of units and conversions, listed in
+// registration order. The strings are static and never need freeing.
+std::vector<CategoryInfo> listCategories();
+std::vector<ConversionInfo> listConversions();
+std::vector<ConversionInfo> listConversions(Category category);
+std::vector<UnitInfo> unitsOf(Dimension dimension);
+// Looks a unit up by name, symbol or alias, ignoring ASCII case, without
+// allocating
+const UnitInfo* findUnit(std::string_view name); // nullptr if unknown
+
+// Other spellings of units, e.g. {"kilometre", "Kilometers"}. Wherever a
+// unit name is accepted (including within "XToY" conversion names), its
+// symbol or an alias in any case works too.
+struct UnitAlias {
+    const char* alias;
+    const char* unit;
+};
+std::vector<UnitAlias> listUnitAliases();
+
+// Dense handle for a unit: its position in the unit table, so that
+// unitInfo(id) lists units in the same order as the queries above
+using UnitId = std::uint16_t;
+UnitId unitId(std::string_view name); // throws std::invalid_argument if unknown
+const UnitInfo& unitInfo(UnitId id);    // throws std::out_of_range if unknown
+std::size_t unitCount();
+
+// A reading with its standard uncertainty and the interval known to hold it,
+// all in the same unit. Leave uncertainty 0 and low == high == value when
+// only one of them is known.
+struct Measurement {
+    double value;
+    double uncertainty; // one standard deviation, never negative
+    double low;
+    double high;
+};
+
+// Statistics of a batch of converted values, in the target unit
+struct ConversionSummary {
+    double sum;
+    double mean;             // NaN, like min and max, for an empty batch
+    double min;
+    double max;
+    std::size_t count;
+    std::size_t outOfRange;  // inputs beyond UnitConverter::clampLimit
+};
+
+// How summarize() adds up values
+enum class Summation {
+    Plain,       // fastest; error grows with the number of values
+    Compensated  // Neumaier-compensated, accurate to about one rounding
+};
+
+enum class Comparison { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+// A filter on source-unit values: those in [low, high] match, or those
+// outside it when `negated`. An empty range (low > high) matches nothing.
+struct SourceRange {
+    double low;
+    double high;
+    bool negated;
+
+    bool matches(double value) const { return (value >= low && value <= high) != negated; }
+    // Writes the indices of matching values to `indices` and returns how many
+    std::size_t select(const double* values, std::size_t count, std::size_t* indices) const;
+};
+
+// Numeric handle for a conversion between two units, for callers that would rather
+// not look a conversion up by name for every value
+using ConversionId = std::uint32_t;
 
 class UnitConverter {
 private:
-    std::map<std::string, std::function<double(double)>> conversionFunctions;
+    // Lower bound an input must respect: it is rejected when
+    // (value + shift) * num / den < minimum
+    struct ValidationRule {
+        double shift;
+        double num;
+        double den;
+        double minimum;
+        const char* message;
+
+        bool rejects(double value) const {
+            return (value + shift) * num / den < minimum;
+        }
+    };
+
+    static constexpr ConversionId noConversion = ~ConversionId(0);
+
+    // A conversion as plain data: inputs are validated against `rule`, then
+    // converted to (x + shift) / divisor if divisor is non-zero, else to
+    // x * scale + offset. Its name is built from the two units when asked for.
+    struct Conversion {
+        ValidationRule rule;
+        double scale;   // x * scale + offset up to rounding, exactly unless divisor is non-zero
+        double offset;
+        double shift;
+        double divisor;
+        UnitId from;
+        UnitId to;
+    };
+
+    std::vector<Conversion> conversions; // registered, indexed by ConversionId
+
+    // How to convert between one pair of units of the same dimension: with a
+    // registered conversion if there is one, else with the affine
+    // coefficients derived from the unit table. Unregistered pairs get no
+    // Conversion of their own; their id is conversions.size() plus the
+    // pair's index, and conversionAt() builds the Conversion on demand.
+    struct UnitPair {
+        double scale;
+        double offset;
+        ConversionId conversion; // noConversion if none is registered
+        UnitId from;
+        UnitId to;
+    };
+    // One dense table per dimension, stored back to back; the pair (from, to)
+    // is at pairs[pairRows[from] + pairColumns[to]], where the column is the
+    // unit's position within its dimension
+    std::vector<UnitPair> pairs;
+    std::vector<std::size_t> pairRows;
+    std::vector<std::size_t> pairColumns;
+    std::vector<ValidationRule> unitRules; // by UnitId, for inputs in that unit
+
+    std::uint64_t instanceId;          // tells converters apart in per-thread caches
+    std::size_t resultCacheSize = 0;   // entries per thread, 0 when disabled
+
+    static ValidationRule validationRuleFor(std::string_view conversionType);
+    static ValidationRule unitRule(UnitId unit);
+    static double prepareValue(const ValidationRule& rule, double value, ClampPolicy policy, bool* clamped);
+    static std::size_t prepareBatch(const ValidationRule& rule, const double* input, double* output,
+                                    std::size_t count, ClampPolicy policy);
+    const UnitPair* findPair(UnitId from, UnitId to) const; // nullptr across dimensions
+    const UnitPair* findPair(std::string_view conversionType) const;
+    ConversionId pairConversionId(const UnitPair& pair) const;
+    Conversion conversionAt(ConversionId id) const; // throws std::out_of_range for unknown ids
+    std::size_t convertBatch(const Conversion& conversion, const double* input, double* output,
+                             std::size_t count, ClampPolicy policy) const;
+    // Applies the conversion's arithmetic to values already validated and clamped
+    static double applyConversion(const Conversion& conversion, double value);
+    static void applyConversion(const Conversion& conversion, double* values, std::size_t count);
+
+    ConversionSummary summarize(const Conversion& conversion, const double* input, std::size_t count,
+                                ClampPolicy policy, Summation summation, unsigned threads) const;
+
+    template <typename Function>
+    static SourceRange pushDown(const Function& function, double scale, Comparison comparison, double constant);
+
+    void buildUnitPairs();
+    void registerConversion(const std::string& name, double scale, double offset, double shift, double divisor);
 
     // Private methods for registering each category of conversions
     void registerTemperatureConversions();
     void registerDistanceConversions();
     void registerWeightConversions();
     void registerVolumeConversions();
+    // Speed, density and flow rate, derived from the base conversions
+    void registerCompoundConversions();
 
     // Central method to register all conversions
     void registerConversionFunctions();
 
 public:
+    static constexpr double clampLimit = 1e6;
+
     UnitConverter();
-    double convert(const std::string& conversionType, double value) const;
+
+    // Converts a single value. `conversionType` names the source and target
+    // unit, as in "KilometersToMiles"; any two units of one dimension work,
+    // registered conversion or not. If `clamped` is given it is set to
+    // whether the input was beyond clampLimit, whatever the policy.
+    double convert(std::string_view conversionType, double value,
+                   ClampPolicy policy = ClampPolicy::Saturate, bool* clamped = nullptr) const;
+
+    // Converts `count` values from `input` into `output` (which may alias `input`)
+    // and returns how many inputs were beyond clampLimit. Throws like convert();
+    // the contents of `output` are unspecified after a throw.
+    std::size_t convertBatch(const std::string& conversionType, const double* input, double* output,
+                             std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    // Every pair of units of one dimension has an id, so any name convert()
+    // accepts does too. The conversions listed by listConversions() come
+    // first, in registration order, followed by the unit pair table (pairs
+    // such as "KilometersToFeet"; the entries of registered pairs repeat
+    // their conversion). Ids stay valid for the lifetime of the converter.
+    // conversionId() throws std::invalid_argument for unknown types or units
+    // of different dimensions; the id-based overloads throw std::out_of_range
+    // for unknown ids. Names are built from the canonical unit names.
+    ConversionId conversionId(const std::string& conversionType) const;
+    ConversionId conversionId(UnitId from, UnitId to) const;
+    std::string conversionName(ConversionId id) const;
+    std::size_t conversionCount() const { return conversions.size() + pairs.size(); }
+
+    // Coefficients with convert(id, x) == x * scale + offset, up to rounding
+    struct AffineMap {
+        double scale;
+        double offset;
+    };
+    AffineMap affineMap(ConversionId id) const;
+
+    // Everything convert(id, x) does under one policy, as plain data that
+    // callers converting one element at a time (such as converted views)
+    // copy once and apply inline: no lookup or result cache per element,
+    // and the same results and exceptions as convert().
+    struct ElementConversion {
+        ValidationRule rule;
+        double low, high;    // clamp bounds of the policy
+        bool rejectBeyondLimit;
+        double scale, offset;
+        double shift, divisor;
+
+        double operator()(double value) const {
+            if (rule.rejects(value)) throw std::invalid_argument(rule.message);
+            if (rejectBeyondLimit && (value > clampLimit || value < -clampLimit)) {
+                throw std::invalid_argument("Value exceeds the supported conversion range.");
+            }
+            value = std::min(std::max(value, low), high);
+            return divisor != 0.0 ? (value + shift) / divisor : value * scale + offset;
+        }
+    };
+    ElementConversion elementConversion(ConversionId id, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    double convert(ConversionId id, double value,
+                   ClampPolicy policy = ClampPolicy::Saturate, bool* clamped = nullptr) const;
+    std::size_t convertBatch(ConversionId id, const double* input, double* output,
+                             std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    // Like convertBatch(), but instead of throwing for invalid values it sets
+    // valid[i] to 0 and output[i] to NaN for each of them (values beyond
+    // clampLimit count as invalid under ClampPolicy::Reject).
+    std::size_t convertBatchChecked(ConversionId id, const double* input, double* output, std::uint8_t* valid,
+                                    std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+    // The same for one value, safe to call from parallel unsequenced
+    // algorithms: never throws, locks or allocates, and bypasses the result
+    // cache. `id` must be valid. accepts() tells whether a value is valid.
+    double convertChecked(ConversionId id, double value, ClampPolicy policy = ClampPolicy::Saturate) const noexcept;
+    bool accepts(ConversionId id, double value, ClampPolicy policy = ClampPolicy::Saturate) const noexcept;
+
+    // Converts and reduces `count` values in one pass without storing the
+    // converted values: inputs are validated and clamped like convertBatch()
+    // (and throw the same way), reduced in the source unit, and the results
+    // converted once, which is exact for these affine conversions up to
+    // rounding. With threads > 1 the batch is split across that many threads.
+    ConversionSummary summarize(ConversionId id, const double* input, std::size_t count,
+                                ClampPolicy policy = ClampPolicy::Saturate,
+                                Summation summation = Summation::Plain, unsigned threads = 1) const;
+    ConversionSummary summarize(const std::string& conversionType, const double* input, std::size_t count,
+                                ClampPolicy policy = ClampPolicy::Saturate,
+                                Summation summation = Summation::Plain, unsigned threads = 1) const;
+
+    // Rewrites the predicate `convert(x) <comparison> constant`, with the
+    // constant in the target unit, into the source-unit range of x that
+    // satisfies it, so raw values can be filtered without converting them.
+    // The range matches exactly the values whose conversion (without
+    // clamping) satisfies the predicate, including rounding at the boundary
+    // and decreasing conversions. Values are not validated. Throws
+    // std::invalid_argument unless `constant` is finite.
+    SourceRange pushDown(ConversionId id, Comparison comparison, double constant) const;
+    SourceRange pushDown(const std::string& conversionType, Comparison comparison, double constant) const;
+
+    // Converts between any two units of the same dimension in O(1), through
+    // the conversion id of the pair. Inputs are
+    // validated against the source unit. Throw std::invalid_argument if the
+    // units measure different dimensions.
+    double convert(UnitId from, UnitId to, double value,
+                   ClampPolicy policy = ClampPolicy::Saturate, bool* clamped = nullptr) const;
+    std::size_t convertBatch(UnitId from, UnitId to, const double* input, double* output,
+                             std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    // Convert measurements: `value` validates and clamps like convertBatch()
+    // (and throws the same way), the uncertainty is scaled by the magnitude of
+    // the conversion's factor, and the bounds are clamped like the value and
+    // converted by the same vectorized kernel, swapping if the factor is
+    // negative, so a value within its bounds stays within them. Bounds are
+    // not validated.
+    Measurement convert(ConversionId id, const Measurement& measurement,
+                        ClampPolicy policy = ClampPolicy::Saturate) const;
+    std::size_t convertBatch(ConversionId id, const Measurement* input, Measurement* output,
+                             std::size_t count, ClampPolicy policy = ClampPolicy::Saturate) const;
+
+    struct CacheStatistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+
+        double hitRate() const { return hits + misses == 0 ? 0.0 : double(hits) / double(hits + misses); }
+    };
+
+    // Memoizes scalar convert() results per thread in a direct-mapped table of
+    // `entries` slots (rounded up to a power of two), keyed by conversion id,
+    // clamp policy and the bits of the input. Pays off when inputs repeat a
+    // lot, e.g. quantized sensor readings. 0 disables it (the default). Set
+    // this before converting from several threads.
+    void setResultCacheSize(std::size_t entries);
+    // Hits and misses of the calling thread's cache for this converter
+    CacheStatistics resultCacheStatistics() const;
 };
 
 // Conversion utility functions
+void convertCategory(const UnitConverter& converter, Category category);
 void convertTemperature(const UnitConverter& converter);
 void convertDistance(const UnitConverter& converter);
 void convertWeight(const UnitConverter& converter);
 void convertVolume(const UnitConverter& converter);
 void displayMenu();
+void setupConsole();
+
+// Runs the interactive menu on std::cin/std::cout until the user exits
+void runInteractive(const UnitConverter& converter);
+
+// Replays recorded menu sessions (the same inputs a user would type, e.g.
+// "1 100 2 5") without showing prompts. Each outcome is written to `out` as a
+// tab-separated record: "ok\t<conversion>\t<value>\t<result>",
+// "error\t<message>" or "exit" at the end of each session. Returns the
+// number of error records.
+std::size_t replaySessions(const UnitConverter& converter, std::istream& script, std::ostream& out);
+
+// Non-interactive mode for `unit_converter <ConversionType> <value>...`;
+// prints nan for each value that cannot be converted
+int runConversionCommand(int argc, char* argv[]);
 
 #endif // UNIT_CONVERTER_H
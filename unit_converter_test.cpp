@@ -3,9 +3,31 @@
 #include <cstring> // for strcmp
 #include <limits>
 #include <sstream> // for std::istringstream
+#include <iomanip>
 #include <vector>
 #include <iostream> // Added to ensure ::std::cin is defined
+#include <string>
+#include <string_view>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "unit_converter.h"
+#include "conversion_server.h"
+#include "conversion_ring.h"
+#include "conversion_async.h"
+#include "conversion_arrow.h"
+#include "conversion_expression.h"
+#include "conversion_quantity.h"
+#include "conversion_sketch.h"
+#include "conversion_scaled.h"
+#include "conversion_views.h"
+#include "conversion_execution.h"
+#include "conversion_strided.h"
+#include <algorithm>
+#include <list>
+#include <future>
 
 using namespace deepstate;
 
@@ -23,8 +45,8 @@ TEST(UnitConverter, ValidConversions) {
     ASSERT_NEAR(converter.convert("KelvinToCelsius", 273.15), 0.0, 1e-9);
 
     // Distance
-    ASSERT_EQ(converter.convert("KilometersToMiles", 1.0), 0.621371);
-    ASSERT_NEAR(converter.convert("MilesToKilometers", 0.621371), 1.0, 1e-9);
+    ASSERT_NEAR(converter.convert("KilometersToMiles", 1.0), 0.621371, 1e-6);
+    ASSERT_EQ(converter.convert("MilesToKilometers", 1.0), 1.609344);
     ASSERT_NEAR(converter.convert("MetersToFeet", 1.0), 3.28084, 1e-5);
     ASSERT_NEAR(converter.convert("FeetToMeters", 3.28084), 1.0, 1e-5);
 
@@ -41,6 +63,44 @@ TEST(UnitConverter, ValidConversions) {
     ASSERT_NEAR(converter.convert("FluidOuncesToMilliliters", 3.3814), 100.0, 1e-1);
 }
 
+TEST(UnitConverter, ExactInversePairs) {
+    UnitConverter converter;
+
+    // Each pair is derived from one exact constant, and the inverse direction
+    // rounds exactly like a division by it
+    static const struct { const char* forward; const char* inverse; double factor; } pairs[] = {
+        {"MilesToKilometers", "KilometersToMiles", 1.609344},
+        {"FeetToMeters", "MetersToFeet", 0.3048},
+        {"PoundsToKilograms", "KilogramsToPounds", 0.45359237},
+        {"OuncesToGrams", "GramsToOunces", 28.349523125},
+        {"GallonsToLiters", "LitersToGallons", 3.785411784},
+        {"FluidOuncesToMilliliters", "MillilitersToFluidOunces", 29.5735295625},
+    };
+
+    for (const auto& pair : pairs) {
+        for (double x : {0.0, 1.0, 2.5, 10.0, 100.0, 12345.678, 999999.0}) {
+            ASSERT_EQ(converter.convert(pair.forward, x), x * pair.factor);
+            ASSERT_EQ(converter.convert(pair.inverse, x), x / pair.factor);
+        }
+        double x = std::fabs(DeepState_Double());
+        if (x <= UnitConverter::clampLimit) {
+            ASSERT_EQ(converter.convert(pair.inverse, x), x / pair.factor);
+        }
+
+        // Round trips are exact when the intermediate result is, and within
+        // one ulp of the input otherwise
+        ASSERT_EQ(converter.convert(pair.inverse, converter.convert(pair.forward, 1.0)), 1.0);
+        ASSERT_EQ(converter.convert(pair.forward, converter.convert(pair.inverse, pair.factor)), pair.factor);
+        ASSERT_EQ(converter.convert(pair.inverse, converter.convert(pair.forward, 1024.0)), 1024.0);
+        for (double value : {x, 1.0 + x / UnitConverter::clampLimit, 12345.678}) {
+            if (!(value <= UnitConverter::clampLimit / 30)) continue; // the forward result must not clamp
+            const double ulp = std::nextafter(value, INFINITY) - value;
+            ASSERT_LE(std::fabs(converter.convert(pair.inverse, converter.convert(pair.forward, value)) - value), ulp);
+            ASSERT_LE(std::fabs(converter.convert(pair.forward, converter.convert(pair.inverse, value)) - value), ulp);
+        }
+    }
+}
+
 TEST(UnitConverter, ZeroAndNearZeroValues) {
     UnitConverter converter;
 
@@ -52,7 +112,7 @@ TEST(UnitConverter, ZeroAndNearZeroValues) {
     // Very small positive values
     ASSERT_NEAR(converter.convert("CelsiusToKelvin", 1e-9), 273.150000001, 1e-9);
     ASSERT_NEAR(converter.convert("MetersToFeet", 1e-9), 3.28084e-9, 1e-15);
-    ASSERT_NEAR(converter.convert("MillilitersToFluidOunces", 1e-9), 3.3814e-11, 1e-17);
+    ASSERT_NEAR(converter.convert("MillilitersToFluidOunces", 1e-9), 3.3814023e-11, 1e-17);
 }
 
 TEST(UnitConverter, JustAboveAbsoluteZero) {
@@ -130,6 +190,287 @@ TEST(UnitConverter, ClampingValues) {
     }
 }
 
+TEST(UnitConverter, ClampPolicies) {
+    UnitConverter converter;
+
+    // Pass-through keeps large values intact
+    ASSERT_NEAR(converter.convert("MetersToFeet", 1e7, ClampPolicy::PassThrough), 3.28084e7, 10.0);
+
+    // The flag reports clamping under every policy
+    bool clamped = false;
+    converter.convert("MetersToFeet", 1e7, ClampPolicy::Saturate, &clamped);
+    ASSERT(clamped);
+    converter.convert("MetersToFeet", 1e7, ClampPolicy::PassThrough, &clamped);
+    ASSERT(clamped);
+    converter.convert("MetersToFeet", 10.0, ClampPolicy::Saturate, &clamped);
+    ASSERT(!clamped);
+
+    // Reject throws instead of converting
+    try {
+        converter.convert("MetersToFeet", 1e7, ClampPolicy::Reject);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        ASSERT(strlen(e.what()) > 0);
+    }
+}
+
+TEST(UnitConverter, BatchConversion) {
+    UnitConverter converter;
+    const double input[] = {1.0, 1e7, 250.0, 2e6};
+    double output[4];
+
+    // Batch results match the scalar path and clamped elements are counted
+    ASSERT_EQ(converter.convertBatch("KilometersToMiles", input, output, 4), 2u);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(output[i], converter.convert("KilometersToMiles", input[i]));
+    }
+
+    ASSERT_EQ(converter.convertBatch("KilometersToMiles", input, output, 4, ClampPolicy::PassThrough), 2u);
+    ASSERT_EQ(output[1], converter.convert("KilometersToMiles", 1e7, ClampPolicy::PassThrough));
+
+    // Any invalid element fails the whole batch
+    const double negative[] = {1.0, -1.0};
+    try {
+        converter.convertBatch("KilometersToMiles", negative, output, 2);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+}
+
+TEST(UnitConverter, MeasurementConversion) {
+    UnitConverter converter;
+    const ConversionId toFahrenheit = converter.conversionId("CelsiusToFahrenheit");
+    const ConversionId toMiles = converter.conversionId("KilometersToMiles");
+
+    // The offset moves value and bounds but not the uncertainty
+    Measurement reading = converter.convert(toFahrenheit, Measurement{20.0, 0.5, 19.0, 21.0});
+    ASSERT_EQ(reading.value, converter.convert(toFahrenheit, 20.0));
+    ASSERT_NEAR(reading.uncertainty, 0.9, 1e-12);
+    ASSERT_NEAR(reading.low, 66.2, 1e-12);
+    ASSERT_NEAR(reading.high, 69.8, 1e-12);
+
+    // Batches may convert in place and count clamped values like plain batches
+    Measurement batch[3] = {{1.0, 0.1, 0.9, 1.1}, {2e6, 0.0, 2e6, 2e6}, {0.0, 0.0, 0.0, 0.0}};
+    ASSERT_EQ(converter.convertBatch(toMiles, batch, batch, 3), 1u);
+    ASSERT_EQ(batch[0].value, converter.convert(toMiles, 1.0));
+    ASSERT_NEAR(batch[0].uncertainty, 0.0621371, 1e-6);
+    ASSERT_LT(batch[0].low, batch[0].value);
+    ASSERT_GT(batch[0].high, batch[0].value);
+    ASSERT_EQ(batch[1].value, converter.convert(toMiles, UnitConverter::clampLimit));
+    ASSERT_EQ(batch[1].low, batch[1].value);
+    ASSERT_EQ(batch[1].high, batch[1].value);
+
+    // Converted values stay within their converted bounds, even when the
+    // bounds are the value itself
+    for (const char* name : {"KilometersToMiles", "FahrenheitToCelsius", "GramsToOunces", "LitersToGallons"}) {
+        const ConversionId id = converter.conversionId(name);
+        for (int i = 0; i < 200; ++i) {
+            const double x = std::ldexp(1.0 + i * 0.0137, i % 22); // up to about 8e6
+            for (const Measurement& m : {Measurement{x, 0.0, x, x}, Measurement{x, 1.0, x * 0.99, x * 1.01}}) {
+                const Measurement converted = converter.convert(id, m);
+                ASSERT_LE(converted.low, converted.value);
+                ASSERT_LE(converted.value, converted.high);
+            }
+        }
+    }
+
+    try {
+        converter.convert(toMiles, Measurement{-1.0, 0.1, -1.1, -0.9});
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+}
+
+TEST(UnitConverter, UnitPairs) {
+    UnitConverter converter;
+    const UnitId kilometers = unitId("Kilometers");
+    const UnitId miles = unitId("Miles");
+    const UnitId feet = unitId("Feet");
+    ASSERT_EQ(std::string(unitInfo(feet).symbol), std::string("ft"));
+    ASSERT_EQ(unitCount(), 21u);
+
+    // Registered pairs go through their conversion, others through the table
+    ASSERT_EQ(converter.convert(kilometers, miles, 5.0), converter.convert("KilometersToMiles", 5.0));
+    ASSERT_NEAR(converter.convert(kilometers, feet, 1.0), 3280.839895, 1e-6);
+    ASSERT_NEAR(converter.convert("FahrenheitToKelvin", 32.0), 273.15, 1e-9);
+    ASSERT_EQ(converter.convert("GramsToGrams", 7.0), 7.0);
+    ASSERT_NEAR(converter.convert("OuncesToPounds", 16.0), 1.0, 1e-12);
+
+    const double input[] = {1.0, 2.0, 2e6};
+    double output[3];
+    ASSERT_EQ(converter.convertBatch("MilesToFeet", input, output, 3), 1u);
+    ASSERT_NEAR(output[1], 10560.0, 1e-8);
+
+    // Inputs are validated against the source unit
+    ASSERT_NEAR(converter.convert("CelsiusToKelvin", -10.0), 263.15, 1e-9);
+    try {
+        converter.convert("CelsiusToFahrenheit", -300.0);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Temperature value below absolute zero is not valid.") == 0);
+    }
+
+    // Every pair of one dimension has an id, registered or not
+    const ConversionId kilometersToFeet = converter.conversionId("KilometersToFeet");
+    ASSERT_EQ(converter.conversionId(kilometers, feet), kilometersToFeet);
+    ASSERT_EQ(converter.conversionName(kilometersToFeet), std::string("KilometersToFeet"));
+    ASSERT_EQ(converter.convert(kilometersToFeet, 5.0), converter.convert(kilometers, feet, 5.0));
+    ASSERT_EQ(converter.conversionId(kilometers, miles), converter.conversionId("KilometersToMiles"));
+    ASSERT(converter.conversionId(kilometers, miles) < listConversions().size());
+    ASSERT(kilometersToFeet >= listConversions().size());
+    try {
+        converter.conversionId(kilometers, unitId("Kelvin"));
+        DeepState_Fail();
+    } catch (const std::invalid_argument&) {
+    }
+    try {
+        converter.convert(kilometers, unitId("Kelvin"), 1.0);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Cannot convert Kilometers to Kelvin.") == 0);
+    }
+}
+
+TEST(UnitConverter, UnitAliases) {
+    UnitConverter converter;
+
+    for (const char* spelling : {"Kilometers", "km", "kilometre", "KILOMETERS", "Km"}) {
+        ASSERT_EQ(std::string(findUnit(spelling)->name), std::string("Kilometers"));
+    }
+    ASSERT_EQ(unitId("degF"), unitId("Fahrenheit"));
+    ASSERT(findUnit("kilometer s") == nullptr);
+    ASSERT(findUnit("gr") == nullptr); // grains, not grams
+    for (const UnitAlias& alias : listUnitAliases()) {
+        ASSERT_EQ(std::string(findUnit(alias.alias)->name), std::string(alias.unit));
+    }
+
+    // Conversion names accept every spelling on both sides
+    const double miles = converter.convert("KilometersToMiles", 12.0);
+    ASSERT_EQ(converter.convert("kmToMi", 12.0), miles);
+    ASSERT_EQ(converter.convert("KILOMETRESTOMILES", 12.0), miles);
+
+    // Views into larger buffers work without copying
+    const std::string_view line = "12 kilometres to miles";
+    ASSERT_EQ(std::string(findUnit(line.substr(3, 10))->name), std::string("Kilometers"));
+    ASSERT_EQ(unitId(line.substr(17)), unitId("Miles"));
+    ASSERT_EQ(converter.convert(std::string_view("xkmToMix").substr(1, 6), 12.0), miles);
+    ASSERT_EQ(converter.conversionId("kilometerTOmile"), converter.conversionId("KilometersToMiles"));
+    ASSERT_EQ(converter.convert("\u00b0CTo\u00b0F", 100.0), 212.0);
+}
+
+TEST(UnitConverter, CompoundConversions) {
+    UnitConverter converter;
+
+    // Factors come from the base conversions
+    ASSERT_NEAR(converter.convert("KilometersPerHourToMilesPerHour", 100.0), 62.1371192, 1e-6);
+    ASSERT_NEAR(converter.convert("MilesPerHourToKilometersPerHour", 60.0), 96.56064, 1e-9);
+    ASSERT_NEAR(converter.convert("KilogramsPerLiterToPoundsPerGallon", 1.0), 8.34540445, 1e-7);
+    ASSERT_NEAR(converter.convert("PoundsPerGallonToKilogramsPerLiter", 8.34540445), 1.0, 1e-8);
+    ASSERT_NEAR(converter.convert("LitersPerMinuteToGallonsPerHour", 1.0), 15.8503231, 1e-6);
+    ASSERT_NEAR(converter.convert("GallonsPerHourToLitersPerMinute", 15.8503231), 1.0, 1e-8);
+
+    try {
+        converter.convert("KilogramsPerLiterToPoundsPerGallon", -1.0);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative density values are not valid.") == 0);
+    }
+
+    ASSERT_EQ(listConversions(Category::FlowRate).size(), 2u);
+    ASSERT_EQ(std::string(findUnit("MilesPerHour")->symbol), std::string("mph"));
+}
+
+TEST(UnitConverter, ConversionSummaries) {
+    UnitConverter converter;
+
+    std::vector<double> readings(300001);
+    for (size_t i = 0; i < readings.size(); ++i) readings[i] = double(i % 1000) / 10.0;
+    std::vector<double> converted(readings.size());
+    converter.convertBatch("CelsiusToFahrenheit", readings.data(), converted.data(), readings.size());
+    double expectedSum = 0.0;
+    for (double value : converted) expectedSum += value;
+
+    // Same results alone, split over threads, compensated or not
+    for (unsigned threads : {1u, 4u}) {
+        for (Summation summation : {Summation::Plain, Summation::Compensated}) {
+            ConversionSummary summary = converter.summarize("CelsiusToFahrenheit", readings.data(), readings.size(),
+                                                            ClampPolicy::Saturate, summation, threads);
+            ASSERT_EQ(summary.count, readings.size());
+            ASSERT_NEAR(summary.sum, expectedSum, 1e-6 * expectedSum);
+            ASSERT_NEAR(summary.mean, expectedSum / readings.size(), 1e-9);
+            ASSERT_EQ(summary.min, 32.0);
+            ASSERT_EQ(summary.max, converter.convert("CelsiusToFahrenheit", 99.9));
+        }
+    }
+
+    // Affine pairs without a registered conversion work too
+    const double feet[] = {3.0, 6.0, 2e6};
+    ConversionSummary miles = converter.summarize("FeetToMiles", feet, 3);
+    ASSERT_EQ(miles.outOfRange, 1u);
+    ASSERT_NEAR(miles.max, 1e6 / 5280.0, 1e-9);
+
+    ConversionSummary empty = converter.summarize("KilometersToMiles", feet, 0);
+    ASSERT_EQ(empty.sum, 0.0);
+    ASSERT(std::isnan(empty.mean));
+
+    const double negative[] = {1.0, -1.0};
+    try {
+        converter.summarize("KilometersToMiles", negative, 2);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+}
+
+TEST(UnitConverter, PredicatePushdown) {
+    UnitConverter converter;
+
+    // Every comparison agrees with converting first, right at the boundary
+    const Comparison comparisons[] = {Comparison::Less, Comparison::LessEqual, Comparison::Greater,
+                                      Comparison::GreaterEqual, Comparison::Equal, Comparison::NotEqual};
+    // Offsets such as 32 F and 273.15 K put the boundary at or next to a
+    // source value of zero, many ulps away from where the search starts
+    for (const char* type : {"KilometersToMiles", "FahrenheitToCelsius", "FeetToKilometers", "CelsiusToFahrenheit",
+                             "CelsiusToKelvin", "KelvinToCelsius"}) {
+        for (double constant : {100.0, 0.1, 37.5, -17.0, 0.0, 32.0, 273.15, -273.15}) {
+            for (Comparison comparison : comparisons) {
+                const SourceRange range = converter.pushDown(type, comparison, constant);
+                double x = std::isfinite(range.low) ? range.low : range.high;
+                for (int i = 0; i < 8; ++i) x = std::nextafter(x, -1e300);
+                for (int i = 0; i < 16; ++i, x = std::nextafter(x, 1e300)) {
+                    // Values the conversion rejects, such as negative
+                    // distances, have nothing to compare
+                    double converted;
+                    try {
+                        converted = converter.convert(type, x, ClampPolicy::PassThrough);
+                    } catch (const std::invalid_argument&) {
+                        continue;
+                    }
+                    bool expected = false;
+                    switch (comparison) {
+                    case Comparison::Less: expected = converted < constant; break;
+                    case Comparison::LessEqual: expected = converted <= constant; break;
+                    case Comparison::Greater: expected = converted > constant; break;
+                    case Comparison::GreaterEqual: expected = converted >= constant; break;
+                    case Comparison::Equal: expected = converted == constant; break;
+                    case Comparison::NotEqual: expected = converted != constant; break;
+                    }
+                    ASSERT_EQ(range.matches(x), expected);
+                }
+            }
+        }
+    }
+
+    const double kilometers[] = {50.0, 200.0, 160.0, 170.0};
+    size_t indices[4];
+    const SourceRange farther = converter.pushDown(converter.conversionId("KilometersToMiles"), Comparison::Greater, 100.0);
+    ASSERT_EQ(farther.select(kilometers, 4, indices), 2u);
+    ASSERT_EQ(indices[0], 1u);
+    ASSERT_EQ(indices[1], 3u);
+}
+
 TEST(UnitConverter, InvalidConversionType) {
     UnitConverter converter;
 
@@ -203,6 +544,698 @@ TEST(UnitConverter, FuzzTestAllCategories) {
     }
 }
 
+TEST(UnitConverter, Metadata) {
+    UnitConverter converter;
+
+    ASSERT_EQ(listCategories().size(), 7u);
+
+    // Every listed conversion is registered under its name, ahead of the
+    // pairs derived from the unit table
+    std::vector<ConversionInfo> all = listConversions();
+    ASSERT(all.size() < converter.conversionCount());
+    for (const ConversionInfo& info : all) {
+        ASSERT(converter.conversionId(info.name) < all.size());
+        ASSERT_EQ(converter.conversionName(converter.conversionId(info.name)), std::string(info.name));
+        ASSERT(findUnit(info.from) != nullptr);
+        ASSERT(findUnit(info.to) != nullptr);
+        ASSERT(findUnit(info.from)->dimension == findUnit(info.to)->dimension);
+    }
+
+    std::vector<ConversionInfo> distance = listConversions(Category::Distance);
+    ASSERT_EQ(distance.size(), 4u);
+    ASSERT_EQ(std::string(distance[0].name), std::string("KilometersToMiles"));
+
+    std::vector<UnitInfo> masses = unitsOf(Dimension::Mass);
+    ASSERT_EQ(masses.size(), 4u);
+    ASSERT_EQ(std::string(findUnit("Miles")->symbol), std::string("mi"));
+    ASSERT(findUnit("Furlongs") == nullptr);
+}
+
+TEST(UnitConverter, ResultCache) {
+    UnitConverter converter;
+    UnitConverter uncached;
+    converter.setResultCacheSize(100);
+
+    // Repeated inputs hit the cache and give the same results
+    const ConversionId id = converter.conversionId("FahrenheitToCelsius");
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_EQ(converter.convert(id, i * 10.0), uncached.convert(id, i * 10.0));
+        }
+    }
+    UnitConverter::CacheStatistics statistics = converter.resultCacheStatistics();
+    ASSERT_EQ(statistics.hits + statistics.misses, 30u);
+    ASSERT(statistics.hits >= 10u);
+
+    // The clamp flag and policy are part of what is cached
+    bool clamped = false;
+    converter.convert(id, 2e6, ClampPolicy::Saturate, &clamped);
+    converter.convert(id, 2e6, ClampPolicy::Saturate, &clamped);
+    ASSERT(clamped);
+    ASSERT_EQ(converter.convert(id, 2e6, ClampPolicy::PassThrough), uncached.convert(id, 2e6, ClampPolicy::PassThrough));
+
+    // Invalid inputs are never cached
+    for (int i = 0; i < 2; ++i) {
+        try {
+            converter.convert(id, -1000.0);
+            DeepState_Fail();
+        } catch (const std::invalid_argument& e) {
+            ASSERT(strlen(e.what()) > 0);
+        }
+    }
+}
+
+TEST(UnitConverter, CommandLineMode) {
+    char program[] = "unit_converter";
+    char type[] = "KilometersToMiles";
+    char first[] = "12.5";
+    char second[] = "13.1";
+    char invalid[] = "abc";
+    char negative[] = "-1";
+    char unknown[] = "MetersToYards";
+
+    char* valid[] = {program, type, first, second};
+    ASSERT_EQ(runConversionCommand(4, valid), 0);
+
+    char* badValue[] = {program, type, first, invalid};
+    ASSERT_EQ(runConversionCommand(4, badValue), 1);
+
+    char* badRange[] = {program, type, negative};
+    ASSERT_EQ(runConversionCommand(3, badRange), 1);
+
+    char* badType[] = {program, unknown, first};
+    ASSERT_EQ(runConversionCommand(3, badType), 1);
+
+    char* noValues[] = {program, type};
+    ASSERT_EQ(runConversionCommand(2, noValues), 2);
+}
+
+// Appends one conversion request frame to `frame`
+static void appendRequest(std::string& frame, std::uint32_t id, const std::string& type, const std::vector<double>& values) {
+    RequestHeader header{id, static_cast<std::uint16_t>(type.size()), 0, static_cast<std::uint32_t>(values.size())};
+    frame.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    frame.append(type);
+    frame.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+}
+
+static bool readFully(int fd, void* buffer, size_t size) {
+    char* out = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t received = read(fd, out, size);
+        if (received <= 0) return false;
+        out += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+TEST(UnitConverter, ConversionServer) {
+    UnitConverter converter;
+    const std::string path = "/tmp/unit_converter_test_" + std::to_string(getpid()) + ".sock";
+    ConversionServer server(converter, path);
+    std::thread serving([&server] { server.run(); });
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT(fd >= 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    ASSERT(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+    // Pipeline three requests before reading any response
+    std::string frames;
+    appendRequest(frames, 1, "KilometersToMiles", {1.0, 2e6});
+    appendRequest(frames, 2, "MetersToYards", {1.0});
+    appendRequest(frames, 3, "CelsiusToFahrenheit", {100.0});
+    ASSERT(write(fd, frames.data(), frames.size()) == static_cast<ssize_t>(frames.size()));
+
+    ResponseHeader response;
+    double values[2];
+    ASSERT(readFully(fd, &response, sizeof(response)));
+    ASSERT_EQ(response.requestId, 1u);
+    ASSERT_EQ(response.status, static_cast<std::uint32_t>(ResponseHeader::Ok));
+    ASSERT_EQ(response.count, 2u);
+    ASSERT_EQ(response.clampedCount, 1u);
+    ASSERT(readFully(fd, values, sizeof(values)));
+    ASSERT_EQ(values[0], converter.convert("KilometersToMiles", 1.0));
+    ASSERT_EQ(values[1], converter.convert("KilometersToMiles", 2e6));
+
+    ASSERT(readFully(fd, &response, sizeof(response)));
+    ASSERT_EQ(response.requestId, 2u);
+    ASSERT_EQ(response.status, static_cast<std::uint32_t>(ResponseHeader::Error));
+    std::string message(response.count, '\0');
+    ASSERT(readFully(fd, &message[0], message.size()));
+    ASSERT_EQ(message, std::string("Invalid conversion type: MetersToYards"));
+
+    ASSERT(readFully(fd, &response, sizeof(response)));
+    ASSERT_EQ(response.requestId, 3u);
+    ASSERT(readFully(fd, values, sizeof(double)));
+    ASSERT_EQ(values[0], 212.0);
+
+    close(fd);
+    server.stop();
+    serving.join();
+}
+
+TEST(UnitConverter, ConversionServerBackpressure) {
+    UnitConverter converter;
+    const std::string path = "/tmp/unit_converter_test_bp_" + std::to_string(getpid()) + ".sock";
+    ConversionServer server(converter, path);
+    std::thread serving([&server] { server.run(); });
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    ASSERT(fd >= 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    ASSERT(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+    // Pipeline requests without reading any response: the server stops
+    // reading well before it has buffered them all
+    std::string frame;
+    appendRequest(frame, 0, "KilometersToMiles", std::vector<double>(1024, 1.0));
+    const std::size_t limit = 64u << 20;
+    std::size_t sent = 0;
+    int stalls = 0;
+    while (sent < limit && stalls < 5) {
+        const std::size_t partial = sent % frame.size();
+        const ssize_t n = send(fd, frame.data() + partial, frame.size() - partial, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+            stalls = 0;
+        } else {
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+            ++stalls;
+            usleep(10000);
+        }
+    }
+    ASSERT_LT(sent, limit);
+
+    // Every complete request is still answered once the client reads
+    shutdown(fd, SHUT_WR);
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    std::size_t responses = 0;
+    ResponseHeader response;
+    std::vector<double> values(1024);
+    while (readFully(fd, &response, sizeof(response))) {
+        ASSERT_EQ(response.status, static_cast<std::uint32_t>(ResponseHeader::Ok));
+        ASSERT(readFully(fd, values.data(), values.size() * sizeof(double)));
+        ++responses;
+    }
+    ASSERT_EQ(responses, sent / frame.size());
+
+    close(fd);
+    server.stop();
+    serving.join();
+}
+
+TEST(UnitConverter, ConversionIds) {
+    UnitConverter converter;
+
+    ConversionId id = converter.conversionId("MetersToFeet");
+    ASSERT_EQ(converter.conversionName(id), std::string("MetersToFeet"));
+    ASSERT_EQ(converter.convert(id, 2.0), converter.convert("MetersToFeet", 2.0));
+    ASSERT(converter.conversionCount() >= 16u);
+
+    try {
+        converter.conversionId("MetersToYards");
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        ASSERT(strstr(e.what(), "Invalid conversion type") != nullptr);
+    }
+}
+
+TEST(UnitConverter, ConversionRing) {
+    UnitConverter converter;
+    const std::string name = "/unit_converter_test_" + std::to_string(getpid());
+    ConversionRing service = ConversionRing::create(name, 8);
+    std::thread serving([&] { service.serve(converter); });
+
+    ConversionRing producer = ConversionRing::attach(name);
+    ASSERT_EQ(producer.capacity(), 8u);
+
+    // More values than fit in the ring at once, with one invalid value
+    std::vector<double> input;
+    for (int i = 0; i < 20; ++i) input.push_back(i == 5 ? -1.0 : i * 10.0);
+    const ConversionId id = converter.conversionId("KilometersToMiles");
+
+    std::vector<double> output;
+    std::vector<RingStatus> statuses;
+    uint32_t sent = 0;
+    while (output.size() < input.size()) {
+        sent += producer.submit(id, input.data() + sent, static_cast<uint32_t>(input.size()) - sent);
+        producer.waitForResults();
+        double results[8];
+        RingStatus resultStatus[8];
+        uint32_t count = producer.collect(results, resultStatus, 8);
+        output.insert(output.end(), results, results + count);
+        statuses.insert(statuses.end(), resultStatus, resultStatus + count);
+    }
+
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (i == 5) {
+            ASSERT(statuses[i] == RingStatus::Invalid);
+            ASSERT(std::isnan(output[i]));
+        } else {
+            ASSERT(statuses[i] == RingStatus::Ok);
+            ASSERT_EQ(output[i], converter.convert(id, input[i]));
+        }
+    }
+
+    service.shutdown();
+    serving.join();
+}
+
+// Fire-and-forget coroutine used to drive convertAsync() in tests
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static DetachedTask convertInCoroutine(const UnitConverter& converter, const std::vector<double>& input,
+                                       std::vector<double>& output, std::promise<std::size_t>& done) {
+    try {
+        done.set_value(co_await convertAsync(converter, "KilometersToMiles", input.data(), output.data(), input.size()));
+    } catch (...) {
+        done.set_exception(std::current_exception());
+    }
+}
+
+TEST(UnitConverter, AsyncConversion) {
+    UnitConverter converter;
+
+    // Small batches complete inline, large ones on the executor
+    for (size_t size : {size_t(10), ConversionAwaitable::inlineThreshold * 4}) {
+        std::vector<double> input(size, 3.0), output(size);
+        input[0] = 2e6;
+        std::promise<std::size_t> done;
+        std::future<std::size_t> result = done.get_future();
+        convertInCoroutine(converter, input, output, done);
+        ASSERT_EQ(result.get(), 1u);
+        ASSERT_EQ(output[size - 1], converter.convert("KilometersToMiles", 3.0));
+    }
+
+    // Errors surface from co_await
+    std::vector<double> input(ConversionAwaitable::inlineThreshold, -1.0), output(input.size());
+    std::promise<std::size_t> done;
+    std::future<std::size_t> result = done.get_future();
+    convertInCoroutine(converter, input, output, done);
+    try {
+        result.get();
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+}
+
+TEST(UnitConverter, ArrowColumnConversion) {
+    UnitConverter converter;
+    const ConversionId id = converter.conversionId("KilometersToMiles");
+
+    // Six values starting at offset 1; index 2 is null and index 3 is invalid
+    const double values[] = {99.0, 1.0, 2e6, 123.0, -4.0, 5.0, 6.0};
+    const uint8_t validity[] = {0x77}; // bits 0-6 set except bit 3 (index 2)
+    const void* buffers[] = {validity, values};
+    ArrowArray input{6, 1, 1, 2, 0, buffers, nullptr, nullptr, [](ArrowArray* a) { a->release = nullptr; }, nullptr};
+    ArrowSchema schema;
+    exportFloat64Schema(&schema, "distance");
+
+    ArrowArray output;
+    ASSERT_EQ(convertArrowColumn(converter, id, &schema, &input, &output), 1u);
+    ASSERT_EQ(output.length, 6);
+    ASSERT_EQ(output.null_count, 2);
+    const uint8_t* outputValidity = static_cast<const uint8_t*>(output.buffers[0]);
+    const double* outputValues = static_cast<const double*>(output.buffers[1]);
+    ASSERT_EQ(outputValidity[0] & 0x3F, 0x33);
+    ASSERT_EQ(outputValues[0], converter.convert(id, 1.0));
+    ASSERT_EQ(outputValues[5], converter.convert(id, 6.0));
+
+    output.release(&output);
+    ASSERT(output.release == nullptr);
+    schema.release(&schema);
+
+    // The checked batch kernel agrees with convert() for divided and affine
+    // conversions, and marks the invalid value
+    const double fahrenheit[] = {-40.0, 32.0, 98.6, -500.0, 2e6};
+    for (const char* type : {"FahrenheitToCelsius", "CelsiusToKelvin"}) {
+        const ConversionId checkedId = converter.conversionId(type);
+        double converted[5];
+        std::uint8_t valid[5];
+        ASSERT_EQ(converter.convertBatchChecked(checkedId, fahrenheit, converted, valid, 5), 1u);
+        for (int i = 0; i < 5; ++i) {
+            ASSERT_EQ(valid[i], i != 3);
+            if (valid[i]) ASSERT_EQ(converted[i], converter.convert(checkedId, fahrenheit[i]));
+        }
+        ASSERT(std::isnan(converted[3]));
+    }
+
+    // Other column types are refused
+    ArrowSchema ints = {"i", "", nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr};
+    try {
+        convertArrowColumn(converter, id, &ints, &input, &output);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        ASSERT(strlen(e.what()) > 0);
+    }
+}
+
+TEST(UnitConverter, CompiledExpressions) {
+    UnitConverter converter;
+    const std::vector<ExpressionVariable> variables = {{"distance_km", "Kilometers"}, {"offset_mi", "Miles"}};
+
+    CompiledExpression expression(converter, "to(Miles, distance_km) * 2 + -(offset_mi - 1) / 4", variables);
+    ASSERT_EQ(expression.resultUnit(), std::string("Miles"));
+    ASSERT_EQ(CompiledExpression(converter, "offset_mi / offset_mi", variables).resultUnit(), std::string());
+
+    // Units compare by canonical unit, and any pair of one dimension converts
+    ASSERT_EQ(CompiledExpression(converter, "to(mi, distance_km) + Miles_offset", {{"distance_km", "km"}, {"Miles_offset", "Miles"}})
+                  .resultUnit(),
+              std::string("Miles"));
+    CompiledExpression feet(converter, "to(Feet, distance_km)", variables);
+    ASSERT_EQ(feet.resultUnit(), std::string("Feet"));
+
+    // Enough records to span several evaluation blocks
+    std::vector<double> distances, offsets, output(1500);
+    for (int i = 0; i < 1500; ++i) {
+        distances.push_back(i * 0.5);
+        offsets.push_back(i * 0.25);
+    }
+    const double* inputs[] = {distances.data(), offsets.data()};
+    expression.evaluate(inputs, output.data(), output.size());
+    for (size_t i = 0; i < output.size(); i += 37) {
+        double expected = converter.convert("KilometersToMiles", distances[i]) * 2 + -(offsets[i] - 1) / 4;
+        ASSERT_EQ(output[i], expected);
+    }
+    feet.evaluate(inputs, output.data(), output.size());
+    for (size_t i = 0; i < output.size(); i += 37) {
+        ASSERT_EQ(output[i], converter.convert(unitId("Kilometers"), unitId("Feet"), distances[i]));
+    }
+
+    // Unit errors are caught at compile time
+    const char* invalid[] = {"distance_km + offset_mi", "to(Miles, 3)", "to(Pounds, distance_km)", "missing * 2", "(1 + 2",
+                             "distance_km * distance_km + distance_km", "offset_mi / distance_km",
+                             "1 / offset_mi", "to(Furlongs, distance_km)"};
+    for (const char* source : invalid) {
+        try {
+            CompiledExpression bad(converter, source, variables);
+            DeepState_Fail();
+        } catch (const std::invalid_argument& e) {
+            ASSERT(strstr(e.what(), "Expression error") != nullptr);
+        }
+    }
+}
+
+TEST(UnitConverter, QuantityParsing) {
+    UnitConverter converter;
+
+    Quantity quantity = parseQuantity("  12.5 km ");
+    ASSERT_EQ(quantity.value, 12.5);
+    ASSERT_EQ(std::string(quantity.unit->name), std::string("Kilometers"));
+    ASSERT_EQ(std::string(parseQuantity("98.6\u00b0F").unit->name), std::string("Fahrenheit"));
+    ASSERT_EQ(std::string(parseQuantity("3 LBS").unit->name), std::string("Pounds"));
+    ASSERT_EQ(std::string(parseQuantity("2 fl oz").unit->name), std::string("FluidOunces"));
+    ASSERT_EQ(parseQuantity("-40 F").value, -40.0);
+    for (const char* bad : {"", "km", "12.5", "12.5 furlongs", "nan km", "1 km x"}) {
+        ASSERT(!parseQuantity(bad, quantity));
+    }
+    // Every unit of the table, whatever its dimension
+    for (std::size_t id = 0; id < unitCount(); ++id) {
+        const UnitInfo& unit = unitInfo(static_cast<UnitId>(id));
+        ASSERT(parseQuantity("1 " + std::string(unit.name)).unit == &unit);
+        ASSERT(parseQuantity("1 " + std::string(unit.symbol)).unit == &unit);
+    }
+
+    QuantityConverter toCelsius(converter, "Celsius");
+    ASSERT_EQ(toCelsius.convert("-40 F"), -40.0);
+    ASSERT_EQ(toCelsius.convert("21.5 C"), 21.5);
+    ASSERT_EQ(toCelsius.convert("300 K"), converter.convert("KelvinToCelsius", 300.0));
+    ASSERT_NEAR(QuantityConverter(converter, "Kelvin").convert("-40 F"), 233.15, 1e-9);
+    ASSERT_NEAR(QuantityConverter(converter, "Feet").convert("5 km"), 16404.199475, 1e-6);
+    try {
+        toCelsius.convert("5 km");
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Cannot convert km to \u00b0C") == 0);
+    }
+
+    // Invalid texts and values are flagged instead of failing the batch
+    const std::string_view texts[] = {"1 mi", "2 miles", "-1 mi", "1 km", "oops", "3 kg"};
+    double output[6];
+    std::uint8_t valid[6];
+    QuantityConverter toKilometers(converter, "Kilometers");
+    toKilometers.convertBatch(texts, output, valid, 6);
+    ASSERT_EQ(output[0], 1.609344);
+    ASSERT_EQ(output[1], 2 * 1.609344);
+    ASSERT_EQ(output[3], 1.0);
+    const std::uint8_t expected[] = {1, 1, 0, 1, 0, 0};
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_EQ(valid[i], expected[i]);
+        ASSERT_EQ(std::isnan(output[i]), !expected[i]);
+    }
+}
+
+TEST(UnitConverter, QuantileSketch) {
+    UnitConverter converter;
+    QuantileSketch sketch(converter, "Celsius");
+    ASSERT(std::isnan(sketch.quantile(0.5)));
+
+    // A shuffled ramp from 0 to 99.999 degrees Celsius, in two halves
+    QuantileSketch other(converter, "C");
+    for (int i = 0; i < 100000; ++i) {
+        const double value = double((i * 7919) % 100000) / 1000.0;
+        (i % 2 ? sketch : other).add(value);
+    }
+    sketch.merge(other);
+    ASSERT_EQ(sketch.count(), 100000u);
+
+    ASSERT_NEAR(sketch.quantile(0.5), 50.0, 0.5);
+    ASSERT_NEAR(sketch.quantile(0.99), 99.0, 0.1);
+    ASSERT_EQ(sketch.quantile(0.0), 0.0);
+    ASSERT_NEAR(sketch.quantile(0.5, "Fahrenheit"), converter.convert("CelsiusToFahrenheit", sketch.quantile(0.5)), 1e-9);
+    ASSERT_NEAR(sketch.quantile(0.99, unitId("K")), sketch.quantile(0.99) + 273.15, 1e-9);
+
+    try {
+        sketch.quantile(0.5, "Miles");
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Cannot convert Celsius to Miles.") == 0);
+    }
+}
+
+TEST(UnitConverter, ScaledIntegerColumns) {
+    UnitConverter converter;
+    const ConversionId toFahrenheit = converter.conversionId("CelsiusToFahrenheit");
+
+    // Hundredths of a degree Celsius: only the encoding changes
+    int32_t raw[] = {-2500, 0, 3712, 10000};
+    ScaledColumn column{raw, 4, {0.01, 0.0}, -2500, 10000};
+    ASSERT(convertScaledColumn(converter, toFahrenheit, column));
+    ASSERT_EQ(raw[2], 3712);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_NEAR(raw[i] * column.encoding.scale + column.encoding.offset,
+                    converter.convert(toFahrenheit, raw[i] * 0.01), 1e-9);
+    }
+
+    // Values beyond the clamp limit have to be re-encoded
+    int32_t distances[] = {5, 2000000000, 70};
+    ScaledColumn far{distances, 3, {1.0, 0.0}, 5, 2000000000};
+    ASSERT(!convertScaledColumn(converter, converter.conversionId("KilometersToMiles"), far));
+    ASSERT_EQ(distances[0], 5);
+    ASSERT_NEAR(distances[1] * far.encoding.scale, converter.convert("KilometersToMiles", 1e6), 1e-3);
+    ASSERT_EQ(far.rawMax, distances[1]);
+
+    // Explicit target encodings: tenths of a degree Fahrenheit
+    int32_t tenths[4];
+    ASSERT_EQ(reencodeScaledColumn(converter, toFahrenheit, raw, tenths, 4, {0.01, 0.0}, {0.1, 0.0}), 0u);
+    ASSERT_EQ(tenths[0], -130);
+    ASSERT_EQ(tenths[3], 2120);
+
+    int32_t frozen[] = {-30000};
+    ScaledColumn invalid{frozen, 1, {0.01, 0.0}, -30000, -30000};
+    try {
+        convertScaledColumn(converter, toFahrenheit, invalid);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Temperature value below absolute zero is not valid.") == 0);
+    }
+}
+
+TEST(UnitConverter, ConvertedViews) {
+    UnitConverter converter;
+    std::vector<double> kilometers = {1.0, 5.0, 2.5, -1.0};
+
+    auto miles = kilometers | views::convert(converter, "KilometersToMiles");
+    static_assert(std::ranges::random_access_range<decltype(miles)>);
+    ASSERT_EQ(miles.size(), 4u);
+    ASSERT_EQ(miles[1], converter.convert("KilometersToMiles", 5.0));
+
+    // Only elements that are read are converted, so the invalid one only
+    // throws when it is reached
+    ASSERT_EQ(std::ranges::max(miles | std::views::take(3)), miles[1]);
+    try {
+        double total = 0.0;
+        for (double value : miles) total += value;
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+
+    // Any range of numbers works, including non-contiguous and owned ones
+    std::list<float> celsius = {0.0f, 100.0f};
+    auto fahrenheit = views::convert(converter, converter.conversionId("CelsiusToFahrenheit"))(celsius);
+    ASSERT_EQ(*std::ranges::next(fahrenheit.begin()), 212.0);
+    auto owned = std::vector<double>{2.0} | views::convert(converter, "LitersToGallons");
+    ASSERT_EQ(*owned.begin(), converter.convert("LitersToGallons", 2.0));
+    auto feet = std::vector<double>{1.5} | views::convert(converter, "KilometersToFeet");
+    ASSERT_EQ(*feet.begin(), converter.convert(unitId("Kilometers"), unitId("Feet"), 1.5));
+
+    // Elements are converted inline, with the same results and errors as convert()
+    const std::vector<double> values = {0.0, 1.0, 37.5, 98.6, 1234.5678, 2e6, -3.0, -500.0};
+    for (ConversionId id = 0; id < converter.conversionCount(); ++id) {
+        for (ClampPolicy policy : {ClampPolicy::Saturate, ClampPolicy::Reject, ClampPolicy::PassThrough}) {
+            auto converted = values | views::convert(converter, id, policy);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                double expected;
+                try {
+                    expected = converter.convert(id, values[i], policy);
+                } catch (const std::invalid_argument& e) {
+                    try {
+                        converted[i];
+                        DeepState_Fail();
+                    } catch (const std::invalid_argument& inlineError) {
+                        ASSERT_EQ(std::string(inlineError.what()), std::string(e.what()));
+                    }
+                    continue;
+                }
+                ASSERT_EQ(converted[i], expected);
+            }
+        }
+    }
+}
+
+TEST(UnitConverter, ParallelAlgorithms) {
+    UnitConverter converter;
+    const std::vector<double> kilometers = {1.0, -2.0, 2e6, 3.0};
+    std::vector<double> miles(kilometers.size());
+
+    // Invalid values become NaN instead of throwing
+    auto toMiles = checkedConversion(converter, "KilometersToMiles");
+    ASSERT(convert(std::execution::unseq, kilometers.begin(), kilometers.end(), miles.begin(), toMiles) ==
+           miles.end());
+    ASSERT_EQ(miles[0], converter.convert("KilometersToMiles", 1.0));
+    ASSERT(std::isnan(miles[1]));
+    ASSERT_EQ(miles[2], converter.convert("KilometersToMiles", 2e6));
+
+    // With valid flags, clamping follows the policy given to the conversion
+    std::vector<std::uint8_t> valid(kilometers.size());
+    auto rejecting = checkedConversion(converter, converter.conversionId("KilometersToMiles"), ClampPolicy::Reject);
+    ASSERT_EQ(convert(std::execution::seq, kilometers.begin(), kilometers.end(), miles.begin(), valid.begin(),
+                      rejecting), 2u);
+    ASSERT(valid[0] && !valid[1] && !valid[2] && valid[3]);
+    ASSERT(std::isnan(miles[2]));
+    ASSERT_EQ(miles[3], converter.convert("KilometersToMiles", 3.0));
+
+    // Unknown conversions throw once, up front
+    try {
+        checkedConversion(converter, ConversionId(converter.conversionCount()));
+        DeepState_Fail();
+    } catch (const std::out_of_range&) {
+    }
+}
+
+TEST(UnitConverter, StridedFields) {
+    UnitConverter converter;
+    struct Reading {
+        std::int64_t timestamp;
+        std::uint32_t sensorId;
+        double value;
+        std::uint8_t flags;
+    };
+    std::vector<Reading> readings(1000);
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        readings[i] = {std::int64_t(i), std::uint32_t(i % 7), double(i) - 200.0, std::uint8_t(i)};
+    }
+
+    // Only the value field changes
+    ASSERT_EQ(convertField(converter, "CelsiusToFahrenheit", readings.data(), readings.size(), &Reading::value), 0u);
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        ASSERT_EQ(readings[i].value, converter.convert("CelsiusToFahrenheit", double(i) - 200.0));
+        ASSERT_EQ(readings[i].timestamp, std::int64_t(i));
+        ASSERT_EQ(readings[i].sensorId, std::uint32_t(i % 7));
+        ASSERT_EQ(readings[i].flags, std::uint8_t(i));
+    }
+
+    // From a field of some records into a packed array, and rejecting like
+    // convertBatch()
+    const ConversionId id = converter.conversionId("KilometersToMiles");
+    std::vector<double> miles(readings.size());
+    ASSERT_EQ(convertStrided(converter, id, &readings[500].value, sizeof(Reading), miles.data(), sizeof(double), 3),
+              0u);
+    ASSERT_EQ(miles[2], converter.convert(id, readings[502].value));
+    try {
+        convertStrided(converter, id, &readings[0].value, sizeof(Reading), readings.size());
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+    }
+
+    // Each chunk is validated before it is written back: a throw leaves the
+    // failing chunk and everything after it untouched
+    readings[950].value = 2e6;
+    readings[990].value = -1.0;
+    const std::vector<Reading> before(readings.begin(), readings.end());
+    for (ClampPolicy policy : {ClampPolicy::Saturate, ClampPolicy::Reject}) {
+        try {
+            convertStrided(converter, id, &readings[300].value, sizeof(Reading), 700, policy);
+            DeepState_Fail();
+        } catch (const std::invalid_argument& e) {
+            DeepState_Assert(strcmp(e.what(), "Negative distance values are not valid.") == 0);
+        }
+        for (std::size_t i = 300 + 2 * 256; i < readings.size(); ++i) {
+            ASSERT_EQ(readings[i].value, before[i].value);
+        }
+    }
+    try {
+        convertStrided(converter, id, &readings[300].value, sizeof(Reading), 680, ClampPolicy::Reject);
+        DeepState_Fail();
+    } catch (const std::invalid_argument& e) {
+        DeepState_Assert(strcmp(e.what(), "Value exceeds the supported conversion range.") == 0);
+    }
+}
+
+TEST(UnitConverter, ReplayMode) {
+    UnitConverter converter;
+
+    // Two recorded sessions: a valid conversion, a bad menu choice and a
+    // rejected value, then a session cut short without choosing Exit
+    std::istringstream script("1\n100\n1\n7\n2\n-5\n1\n5\n4 1 1\n");
+    std::ostringstream out;
+    ASSERT_EQ(replaySessions(converter, script, out), 2u);
+    std::ostringstream gallons;
+    gallons << std::setprecision(17) << converter.convert("LitersToGallons", 1.0);
+    ASSERT_EQ(out.str(), "ok\tCelsiusToFahrenheit\t100\t212\n"
+                         "error\tInvalid option. Please try again.\n"
+                         "error\tError: Negative distance values are not valid.\n"
+                         "exit\n"
+                         "ok\tLitersToGallons\t1\t" + gallons.str() + "\n");
+
+    // Categories added later are listed after Exit, under 6
+    std::istringstream more("6\n1\n100\n1\n6\n4\n5\n");
+    std::ostringstream moreOut;
+    ASSERT_EQ(replaySessions(converter, more, moreOut), 1u);
+    std::ostringstream mph;
+    mph << std::setprecision(17) << converter.convert("KilometersPerHourToMilesPerHour", 100.0);
+    ASSERT_EQ(moreOut.str(), "ok\tKilometersPerHourToMilesPerHour\t100\t" + mph.str() + "\n"
+                             "error\tInvalid category selection.\n"
+                             "exit\n");
+}
+
 TEST(UnitConverter, InteractiveFunctions) {
     UnitConverter converter;
 